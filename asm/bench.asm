@@ -0,0 +1,399 @@
+; measures time of long arithmetic routines
+;
+; every routine is run on operands of 1, 2, 4, ... BENCH_MAX_LENGTH qwords
+; and the best of several runs is printed per qword of the operand, lines
+; are "routine qwords ticks/qword"; time is taken with rdtsc before and
+; rdtscp after the call, fenced by lfence, so it is counted in ticks of the
+; time stamp counter, which run at a constant rate and may differ from
+; core cycles if the cpu changes its frequency
+                section         .text
+
+                extern          add_long_long
+                extern          sub_long_long
+                extern          mul_long_short
+                extern          div_long_short
+                extern          div_long_short_preinv
+                extern          reciprocal_short
+                extern          addmul_1
+                extern          submul_1
+                extern          mul_long_long
+                extern          sqr_long
+                extern          mul_scratch_length
+                extern          copy_long
+                extern          set_zero
+                extern          is_zero
+                extern          alloc_long
+                extern          heap_mark
+                extern          heap_release
+                extern          read_long
+                extern          write_long
+                extern          read_from_memory
+                extern          redirect_output
+                extern          print_string
+                extern          write_char
+                extern          exit
+
+; operands are swept from 1 to BENCH_MAX_LENGTH qwords
+BENCH_MAX_LENGTH: equ           4096
+; every length is run max(BENCH_MIN_RUNS, BENCH_QWORDS / length) times
+BENCH_MIN_RUNS: equ             5
+BENCH_QWORDS:   equ             1 << 16
+; short operand of mul_long_short, addmul_1 and submul_1 and divisor of
+; div_long_short, 10^19
+BENCH_SHORT:    equ             10000000000000000000
+; digits of read_long input per qword of the number
+DIGITS_PER_QWORD: equ           19
+; layout of a case: name, size of name, preparation, measured call
+CASE_NAME:      equ             0
+CASE_NAME_SIZE: equ             8
+CASE_PREPARE:   equ             16
+CASE_RUN:       equ             24
+CASE_SIZE:      equ             32
+O_WRONLY:       equ             1
+
+                global          _start
+_start:
+                call            .init
+
+; r13 -- current case, r12 -- length of operands,
+; r15 -- number of runs left, r14 -- best time
+                mov             r13, cases
+.next_case:
+                mov             r12, 1
+.next_length:
+                mov             rax, BENCH_QWORDS
+                xor             rdx, rdx
+                div             r12
+                mov             r15, BENCH_MIN_RUNS
+                cmp             rax, r15
+                cmova           r15, rax
+                mov             r14, -1
+
+; output of measured routines goes to /dev/null, the heap is released
+; after every run
+.run:
+                call            heap_mark
+                push            rax
+                mov             rax, [null_fd]
+                call            redirect_output
+                call            [r13 + CASE_PREPARE]
+
+                lfence
+                rdtsc
+                lfence
+                shl             rdx, 32
+                or              rax, rdx
+                mov             rbp, rax
+                call            [r13 + CASE_RUN]
+                rdtscp
+                lfence
+                shl             rdx, 32
+                or              rax, rdx
+                sub             rax, rbp
+                cmp             rax, r14
+                cmovb           r14, rax
+
+                mov             rax, 1
+                call            redirect_output
+                pop             rax
+                call            heap_release
+                dec             r15
+                jnz             .run
+
+                call            .report
+                shl             r12, 1
+                cmp             r12, BENCH_MAX_LENGTH
+                jbe             .next_length
+                add             r13, CASE_SIZE
+                cmp             r13, cases_end
+                jb              .next_case
+                jmp             exit
+
+; allocates operands and fills them with pseudorandom qwords (xorshift),
+; operand #1 is always greater than operand #2
+.init:
+                mov             rcx, BENCH_MAX_LENGTH
+                call            alloc_long
+                mov             [operand1], rax
+                call            alloc_long
+                mov             [operand2], rax
+                lea             rcx, [rcx + rcx + 1]
+                call            alloc_long
+                mov             [work], rax
+                mov             rcx, BENCH_MAX_LENGTH
+                mov             rdx, rcx
+                call            mul_scratch_length
+                mov             rcx, rax
+                call            alloc_long
+                mov             [scratch], rax
+                mov             rcx, BENCH_MAX_LENGTH * DIGITS_PER_QWORD / 8 + 1
+                call            alloc_long
+                mov             [digits], rax
+
+                mov             rax, 0x9e3779b97f4a7c15
+                mov             rsi, [operand1]
+                mov             rdi, [operand2]
+                mov             r8, [digits]
+                xor             rcx, rcx
+.fill_loop:
+                mov             rdx, rax
+                shl             rdx, 13
+                xor             rax, rdx
+                mov             rdx, rax
+                shr             rdx, 7
+                xor             rax, rdx
+                mov             rdx, rax
+                shl             rdx, 17
+                xor             rax, rdx
+                mov             rdx, 1 << 63
+                or              rdx, rax
+                mov             [rsi + 8 * rcx], rdx
+                btr             rdx, 63
+                or              rdx, 1
+                mov             [rdi + 8 * rcx], rdx
+                inc             rcx
+                cmp             rcx, BENCH_MAX_LENGTH
+                jb              .fill_loop
+
+; digits are taken from bytes of operand #1 over and over, '1' to '8'
+                xor             rcx, rcx
+.digits_loop:
+                mov             rdx, rcx
+                and             rdx, 8 * BENCH_MAX_LENGTH - 1
+                movzx           eax, byte [rsi + rdx]
+                and             eax, 7
+                add             eax, '1'
+                mov             [r8 + rcx], al
+                inc             rcx
+                cmp             rcx, BENCH_MAX_LENGTH * DIGITS_PER_QWORD
+                jb              .digits_loop
+
+                mov             rbx, BENCH_SHORT
+                call            reciprocal_short
+                mov             [short_inv], r8
+
+                mov             rax, 2
+                mov             rdi, dev_null
+                mov             rsi, O_WRONLY
+                syscall
+                mov             [null_fd], rax
+                ret
+
+; prints "name length ticks/qword" for the current case, ticks per qword
+; are printed with two decimals
+.report:
+                mov             rsi, [r13 + CASE_NAME]
+                mov             rdx, [r13 + CASE_NAME_SIZE]
+                call            print_string
+                mov             al, 0x09
+                call            write_char
+                mov             rax, r12
+                call            .write_qword
+                mov             al, 0x09
+                call            write_char
+
+                imul            rax, r14, 100
+                xor             rdx, rdx
+                div             r12
+                mov             rbx, 100
+                xor             rdx, rdx
+                div             rbx
+                push            rdx
+                call            .write_qword
+                mov             al, '.'
+                call            write_char
+                pop             rax
+                mov             bl, 10
+                div             bl
+                add             al, '0'
+                call            write_char
+                mov             al, ah
+                add             al, '0'
+                call            write_char
+                mov             al, 0x0a
+                call            write_char
+                ret
+
+; prints rax in decimal
+.write_qword:
+                mov             [number], rax
+                mov             rdi, number
+                xor             rcx, rcx
+                test            rax, rax
+                setnz           cl
+                jmp             write_long
+
+; preparations, operands are copied to work if the routine changes them
+prepare_none:
+                ret
+
+prepare_copy:
+                mov             rdi, [work]
+                mov             rsi, [operand1]
+                mov             rcx, r12
+                jmp             copy_long
+
+prepare_zero:
+                mov             rdi, [work]
+                mov             rcx, r12
+                jmp             set_zero
+
+prepare_digits:
+                mov             rsi, [digits]
+                imul            rdx, r12, DIGITS_PER_QWORD
+                jmp             read_from_memory
+
+; measured calls
+run_add:
+                mov             rdi, [work]
+                mov             rcx, r12
+                mov             rsi, [operand2]
+                mov             rdx, r12
+                jmp             add_long_long
+
+run_sub:
+                mov             rdi, [work]
+                mov             rcx, r12
+                mov             rsi, [operand2]
+                mov             rdx, r12
+                jmp             sub_long_long
+
+run_mul_short:
+                mov             rdi, [work]
+                mov             rcx, r12
+                mov             rbx, BENCH_SHORT
+                jmp             mul_long_short
+
+run_div_short:
+                mov             rdi, [work]
+                mov             rcx, r12
+                mov             rbx, BENCH_SHORT
+                jmp             div_long_short
+
+run_div_short_preinv:
+                mov             rdi, [work]
+                mov             rcx, r12
+                mov             rbx, BENCH_SHORT
+                mov             r8, [short_inv]
+                jmp             div_long_short_preinv
+
+run_addmul_1:
+                mov             rdi, [work]
+                mov             rsi, [operand2]
+                mov             rcx, r12
+                mov             rbx, BENCH_SHORT
+                jmp             addmul_1
+
+run_submul_1:
+                mov             rdi, [work]
+                mov             rsi, [operand2]
+                mov             rcx, r12
+                mov             rbx, BENCH_SHORT
+                jmp             submul_1
+
+run_mul:
+                mov             rdi, [work]
+                mov             rsi, [operand1]
+                mov             rcx, r12
+                mov             rbx, [operand2]
+                mov             rdx, r12
+                mov             r8, [scratch]
+                jmp             mul_long_long
+
+run_sqr:
+                mov             rdi, [work]
+                mov             rsi, [operand1]
+                mov             rcx, r12
+                mov             r8, [scratch]
+                jmp             sqr_long
+
+run_set_zero:
+                mov             rdi, [work]
+                mov             rcx, r12
+                jmp             set_zero
+
+run_is_zero:
+                mov             rdi, [work]
+                mov             rcx, r12
+                jmp             is_zero
+
+run_copy:
+                mov             rdi, [work]
+                mov             rsi, [operand1]
+                mov             rcx, r12
+                jmp             copy_long
+
+run_read:
+                jmp             read_long
+
+run_write:
+                mov             rdi, [work]
+                mov             rcx, r12
+                jmp             write_long
+
+
+                section         .rodata
+dev_null:       db              "/dev/null", 0
+add_name:       db              "add_long_long"
+add_name_size:  equ             $ - add_name
+sub_name:       db              "sub_long_long"
+sub_name_size:  equ             $ - sub_name
+mul_short_name: db              "mul_long_short"
+mul_short_name_size: equ        $ - mul_short_name
+div_short_name: db              "div_long_short"
+div_short_name_size: equ        $ - div_short_name
+div_short_preinv_name: db       "div_long_short_preinv"
+div_short_preinv_name_size: equ $ - div_short_preinv_name
+addmul_1_name:  db              "addmul_1"
+addmul_1_name_size: equ         $ - addmul_1_name
+submul_1_name:  db              "submul_1"
+submul_1_name_size: equ         $ - submul_1_name
+mul_name:       db              "mul_long_long"
+mul_name_size:  equ             $ - mul_name
+sqr_name:       db              "sqr_long"
+sqr_name_size:  equ             $ - sqr_name
+set_zero_name:  db              "set_zero"
+set_zero_name_size: equ         $ - set_zero_name
+is_zero_name:   db              "is_zero"
+is_zero_name_size: equ          $ - is_zero_name
+copy_name:      db              "copy_long"
+copy_name_size: equ             $ - copy_name
+read_name:      db              "read_long"
+read_name_size: equ             $ - read_name
+write_name:     db              "write_long"
+write_name_size: equ            $ - write_name
+
+                align           8
+; measured routines, see CASE_SIZE
+cases:
+                dq              add_name, add_name_size, prepare_copy, run_add
+                dq              sub_name, sub_name_size, prepare_copy, run_sub
+                dq              mul_short_name, mul_short_name_size, prepare_copy, run_mul_short
+                dq              div_short_name, div_short_name_size, prepare_copy, run_div_short
+                dq              div_short_preinv_name, div_short_preinv_name_size, prepare_copy, run_div_short_preinv
+                dq              addmul_1_name, addmul_1_name_size, prepare_copy, run_addmul_1
+                dq              submul_1_name, submul_1_name_size, prepare_copy, run_submul_1
+                dq              mul_name, mul_name_size, prepare_none, run_mul
+                dq              sqr_name, sqr_name_size, prepare_none, run_sqr
+                dq              set_zero_name, set_zero_name_size, prepare_none, run_set_zero
+                dq              is_zero_name, is_zero_name_size, prepare_zero, run_is_zero
+                dq              copy_name, copy_name_size, prepare_none, run_copy
+                dq              read_name, read_name_size, prepare_digits, run_read
+                dq              write_name, write_name_size, prepare_copy, run_write
+cases_end:
+
+                section         .bss
+; operands of BENCH_MAX_LENGTH qwords
+operand1:       resq            1
+operand2:       resq            1
+; result of 2 * BENCH_MAX_LENGTH + 1 qwords
+work:           resq            1
+; scratch space of mul_long_long
+scratch:        resq            1
+; decimal digits for read_long
+digits:         resq            1
+; reciprocal of BENCH_SHORT
+short_inv:      resq            1
+null_fd:        resq            1
+; argument of write_long in .write_qword
+number:         resq            1
@@ -0,0 +1,94 @@
+; detection of optional instruction set extensions
+                section         .text
+
+                global          has_bmi2_adx
+                global          has_avx2
+
+; feature bits in ecx of cpuid leaf 1
+CPUID_1_OSXSAVE: equ            1 << 27
+CPUID_1_AVX:    equ             1 << 28
+; feature bits in ebx of cpuid leaf 7
+CPUID_7_AVX2:   equ             1 << 5
+CPUID_7_BMI2:   equ             1 << 8
+CPUID_7_ADX:    equ             1 << 19
+; XCR0 bits of SSE and AVX state, both are saved by the os if AVX is usable
+XCR0_SSE_AVX:   equ             (1 << 1) | (1 << 2)
+
+; checks if mulx (BMI2), adcx and adox (ADX) are supported
+; result:
+;    rax -- 1 if supported, 0 otherwise
+has_bmi2_adx:
+                push            rbx
+                push            rcx
+                push            rdx
+
+                xor             eax, eax
+                cpuid
+                cmp             eax, 7
+                jb              .unsupported
+
+                mov             eax, 7
+                xor             ecx, ecx
+                cpuid
+                and             ebx, CPUID_7_BMI2 | CPUID_7_ADX
+                cmp             ebx, CPUID_7_BMI2 | CPUID_7_ADX
+                jne             .unsupported
+
+                mov             eax, 1
+                jmp             .done
+
+.unsupported:
+                xor             eax, eax
+
+.done:
+                pop             rdx
+                pop             rcx
+                pop             rbx
+                ret
+
+; checks if AVX2 is supported by the cpu and ymm registers are saved by
+; the os (xgetbv)
+; result:
+;    rax -- 1 if supported, 0 otherwise
+has_avx2:
+                push            rbx
+                push            rcx
+                push            rdx
+
+                xor             eax, eax
+                cpuid
+                cmp             eax, 7
+                jb              .unsupported
+
+                mov             eax, 1
+                cpuid
+                and             ecx, CPUID_1_OSXSAVE | CPUID_1_AVX
+                cmp             ecx, CPUID_1_OSXSAVE | CPUID_1_AVX
+                jne             .unsupported
+
+                xor             ecx, ecx
+                xgetbv
+                and             eax, XCR0_SSE_AVX
+                cmp             eax, XCR0_SSE_AVX
+                jne             .unsupported
+
+                mov             eax, 7
+                xor             ecx, ecx
+                cpuid
+                test            ebx, CPUID_7_AVX2
+                jz              .unsupported
+
+                mov             eax, 1
+                jmp             .done
+
+.unsupported:
+                xor             eax, eax
+
+.done:
+                pop             rdx
+                pop             rcx
+                pop             rbx
+                ret
+
+; long_c links this file into C programs, which need no executable stack
+                section         .note.GNU-stack noalloc noexec nowrite progbits
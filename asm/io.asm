@@ -0,0 +1,960 @@
+; input/output of long numbers shared by add, sub and mul
+;
+; numbers are decimal by default, a number with 0x prefix is hexadecimal;
+; option -x makes all numbers hexadecimal (the prefix is optional), option
+; -b makes them binary: length in qwords and qwords, all little-endian,
+; length of a negative result has the highest bit set; input numbers are
+; not negative in any format
+                section         .text
+
+                global          parse_args
+                global          read_long
+                global          write_long
+                global          write_line_end
+                global          write_minus
+                global          read_char
+                global          write_char
+                global          print_string
+                global          flush_output
+                global          read_from_memory
+                global          redirect_output
+                global          exit
+
+                extern          add_long_short
+                extern          mul_long_short
+                extern          chunks_to_long
+                extern          long_to_chunks
+                extern          normalize_long
+                extern          alloc_long
+                extern          heap_mark
+                extern          heap_release
+
+; size of stdin buffer in bytes
+IN_BUF_SIZE:    equ             1 << 16
+; size of stdout buffer in bytes
+OUT_BUF_SIZE:   equ             1 << 16
+; in_mode values: stdin is not inspected yet, is read by blocks to in_buf,
+; is mapped to memory
+IN_UNKNOWN:     equ             0
+IN_STREAM:      equ             1
+IN_MAPPED:      equ             2
+; struct stat layout and constants for map_input
+STAT_BUF_SIZE:  equ             144
+STAT_MODE:      equ             24
+STAT_SIZE:      equ             48
+S_IFMT:         equ             0xf000
+S_IFREG:        equ             0x8000
+SEEK_CUR:       equ             1
+PROT_READ:      equ             1
+MAP_PRIVATE:    equ             2
+; max number of decimal digits that fit into qword
+MAX_CHUNK_DIGITS: equ           19
+; ceil(2^67 / 10), x / 10 == (x * DIV10_MAGIC) >> 67 for any qword x
+DIV10_MAGIC:    equ             0xcccccccccccccccd
+; io_format values: decimal (or hexadecimal with 0x prefix), hexadecimal,
+; binary
+FORMAT_DECIMAL: equ             0
+FORMAT_HEX:     equ             1
+FORMAT_BINARY:  equ             2
+; number of hexadecimal digits in qword
+QWORD_HEX_DIGITS: equ           16
+; binary input is shorter than 2^MAX_BINARY_LENGTH_BITS qwords, larger
+; lengths (negative numbers included) are rejected before anything is
+; allocated
+MAX_BINARY_LENGTH_BITS: equ     40
+
+; sets format of numbers from command line options -x and -b, prints
+; a message and exits on other arguments
+;    rdi -- stack pointer at the program start (address of argc)
+parse_args:
+                push            rax
+                push            rcx
+                push            rdx
+                push            rsi
+                push            rdi
+
+; argc is 0 if the program is run with empty argv, there are no options
+                mov             rcx, [rdi]
+                lea             rsi, [rdi + 16]
+                test            rcx, rcx
+                jz              .done
+.loop:
+                dec             rcx
+                jz              .done
+                mov             rdi, [rsi]
+                cmp             byte [rdi], '-'
+                jne             .unknown
+                mov             al, [rdi + 1]
+                test            al, al
+                jz              .unknown
+                cmp             byte [rdi + 2], 0
+                jne             .unknown
+                cmp             al, 'x'
+                je              .hex
+                cmp             al, 'b'
+                jne             .unknown
+                mov             byte [io_format], FORMAT_BINARY
+                jmp             .next
+.hex:
+                mov             byte [io_format], FORMAT_HEX
+.next:
+                add             rsi, 8
+                jmp             .loop
+
+.done:
+                pop             rdi
+                pop             rsi
+                pop             rdx
+                pop             rcx
+                pop             rax
+                ret
+
+.unknown:
+                push            rdi
+                mov             rsi, unknown_option_msg
+                mov             rdx, unknown_option_msg_size
+                call            print_string
+                pop             rsi
+                xor             rdx, rdx
+.length_loop:
+                cmp             byte [rsi + rdx], 0
+                je              .print
+                inc             rdx
+                jmp             .length_loop
+.print:
+                call            print_string
+                mov             al, 0x0a
+                call            write_char
+                jmp             exit
+
+; read long number from stdin
+; number is a line of decimal digits, the last line may have no line feed;
+; digits are collected into chunks of MAX_CHUNK_DIGITS digits, which are
+; stored at the top of the heap while they are read and then joined into
+; the number by chunks_to_long in O(M(n) log n); hexadecimal and binary
+; numbers are read in linear time (see the beginning of the file)
+; result:
+;    CF=1 if input has ended before the number
+;    rdi -- address of long number
+;    rcx -- length of long number in qwords
+read_long:
+                push            r8
+                push            r9
+                push            r10
+                push            r11
+
+                xor             rcx, rcx
+                call            alloc_long
+                mov             rdi, rax
+; r10 -- number of qwords allocated for the number
+; r11 -- number of chars read
+                xor             r10, r10
+                xor             r11, r11
+                cmp             byte [io_format], FORMAT_BINARY
+                je              .binary
+
+; 0x prefix is skipped, leading 0 without x is a digit that can be dropped
+                call            read_char
+                cmp             rax, '0'
+                jne             .unread
+                inc             r11
+                call            read_char
+                cmp             rax, 'x'
+                je              .hex
+.unread:
+                test            rax, rax
+                js              .no_prefix
+                dec             qword [in_pos]
+.no_prefix:
+                cmp             byte [io_format], FORMAT_HEX
+                je              .hex
+                mov             byte [hex_output], 0
+.chunk:
+                xor             r8, r8
+                xor             r9, r9
+.loop:
+                call            read_char
+                or              rax, rax
+                js              .end_of_input
+                inc             r11
+                cmp             rax, 0x0a
+                je              .last_chunk
+                cmp             rax, '0'
+                jb              .invalid_char
+                cmp             rax, '9'
+                ja              .invalid_char
+
+                sub             rax, '0'
+                imul            r8, r8, 10
+                add             r8, rax
+                inc             r9
+                cmp             r9, MAX_CHUNK_DIGITS
+                jb              .loop
+
+                call            .reserve_qword
+                mov             [rdi + 8 * rcx], r8
+                inc             rcx
+                jmp             .chunk
+
+.end_of_input:
+                test            r11, r11
+                jnz             .last_chunk
+.no_number:
+                pop             r11
+                pop             r10
+                pop             r9
+                pop             r8
+                stc
+                ret
+
+; chunks are stored most significant first, number = chunks * 10^r9 + r8
+.last_chunk:
+                call            .reverse
+                push            rsi
+                mov             rsi, rdi
+                call            chunks_to_long
+                pop             rsi
+                mov             rbx, [pow10 + 8 * r9]
+                call            mul_long_short
+                mov             rax, r8
+                call            add_long_short
+
+.done:
+                pop             r11
+                pop             r10
+                pop             r9
+                pop             r8
+                clc
+                ret
+
+; hexadecimal digits are collected into qwords, which are stored most
+; significant first, r8 -- current qword, r9 -- number of digits in it;
+; at the end qwords are reversed and shifted to make room for r8
+.hex:
+                mov             byte [hex_output], 1
+.hex_chunk:
+                xor             r8, r8
+                xor             r9, r9
+.hex_loop:
+                call            read_char
+                or              rax, rax
+                js              .hex_end
+                inc             r11
+                cmp             rax, 0x0a
+                je              .hex_end
+                mov             rbx, rax
+                sub             rbx, '0'
+                cmp             rbx, 10
+                jb              .hex_digit
+                mov             rbx, rax
+                or              rbx, 0x20
+                sub             rbx, 'a'
+                cmp             rbx, 6
+                jae             .invalid_char
+                add             rbx, 10
+.hex_digit:
+                shl             r8, 4
+                or              r8, rbx
+                inc             r9
+                cmp             r9, QWORD_HEX_DIGITS
+                jb              .hex_loop
+
+                call            .reserve_qword
+                mov             [rdi + 8 * rcx], r8
+                inc             rcx
+                jmp             .hex_chunk
+
+.hex_end:
+                test            r11, r11
+                jz              .no_number
+                call            .reserve_qword
+                call            .reverse
+                push            rdx
+
+; number = qwords * 16^r9 + r8, shift is done from the highest qword
+                mov             rbx, rcx
+                lea             rcx, [4 * r9]
+                mov             qword [rdi + 8 * rbx], 0
+                mov             r9, rbx
+.shift_loop:
+                test            r9, r9
+                jz              .shift_low
+                mov             rax, [rdi + 8 * r9 - 8]
+                mov             rdx, [rdi + 8 * r9]
+                shld            rdx, rax, cl
+                mov             [rdi + 8 * r9], rdx
+                dec             r9
+                jmp             .shift_loop
+.shift_low:
+                mov             rax, [rdi]
+                shl             rax, cl
+                or              rax, r8
+                mov             [rdi], rax
+
+                lea             rcx, [rbx + 1]
+                call            normalize_long
+                pop             rdx
+                jmp             .done
+
+; reverses order of rcx qwords at rdi, uses rax and rbx
+.reverse:
+                push            rdx
+                push            r10
+
+; r10 and rbx -- indices of swapped qwords
+                xor             r10, r10
+                lea             rbx, [rcx - 1]
+.reverse_loop:
+                cmp             r10, rbx
+                jge             .reversed
+                mov             rax, [rdi + 8 * r10]
+                mov             rdx, [rdi + 8 * rbx]
+                mov             [rdi + 8 * rbx], rax
+                mov             [rdi + 8 * r10], rdx
+                inc             r10
+                dec             rbx
+                jmp             .reverse_loop
+.reversed:
+                pop             r10
+                pop             rdx
+                ret
+
+; makes room for one more qword of the number
+.reserve_qword:
+                cmp             r10, rcx
+                ja              .reserved
+                push            rcx
+                mov             rcx, 1
+                call            alloc_long
+                pop             rcx
+                inc             r10
+.reserved:
+                ret
+
+; binary number is read right into its place, the length is read into
+; the first qword
+.binary:
+                mov             rcx, 1
+                call            alloc_long
+                mov             rcx, 8
+                call            read_block
+                jc              .no_number
+                mov             r10, [rdi]
+; length of a negative number has the highest bit set, so it is too large
+; as well
+                mov             rax, r10
+                shr             rax, MAX_BINARY_LENGTH_BITS
+                jnz             .invalid_length
+                mov             rcx, r10
+                call            alloc_long
+                shl             rcx, 3
+                call            read_block
+                jc              .no_number
+                mov             rcx, r10
+                call            normalize_long
+                jmp             .done
+
+.invalid_length:
+                mov             rsi, invalid_length_msg
+                mov             rdx, invalid_length_msg_size
+                call            print_string
+                jmp             exit
+
+.invalid_char:
+                mov             rsi, invalid_char_msg
+                mov             rdx, invalid_char_msg_size
+                call            print_string
+                call            write_char
+                mov             al, 0x0a
+                call            write_char
+
+.skip_loop:
+                call            read_char
+                or              rax, rax
+                js              exit
+                cmp             rax, 0x0a
+                je              exit
+                jmp             .skip_loop
+
+; write long number to stdout
+; number is split into chunks of MAX_CHUNK_DIGITS digits by long_to_chunks
+; in O(M(n) log n), every chunk but the highest one is written with leading
+; zeros; number is written in hexadecimal with 0x prefix if the last number
+; read was hexadecimal and in binary if format is binary
+;    rdi -- argument (long number)
+;    rcx -- length of long number in qwords
+; result:
+;    long number is destroyed
+write_long:
+                cmp             byte [io_format], FORMAT_BINARY
+                je              write_binary_long
+                cmp             byte [hex_output], 0
+                jne             write_hex_long
+                push            rax
+                push            rcx
+                push            rbp
+                push            r8
+                push            r9
+                push            r10
+                push            r11
+
+                call            heap_mark
+                push            rax
+
+; digits are written backwards from rbp, every qword gives at most
+; 20 digits, 3 qwords are allocated per qword of the number
+                push            rcx
+                inc             rcx
+                lea             rcx, [rcx + 2 * rcx]
+                call            alloc_long
+                lea             rbp, [rax + 8 * rcx]
+                pop             rcx
+
+                call            long_to_chunks
+                mov             r8, rsi
+                mov             rsi, rbp
+                mov             r10, DIV10_MAGIC
+
+; chunks are written from the lowest one, r11 -- index of the next chunk
+                xor             r9, r9
+                xor             r11, r11
+                test            rcx, rcx
+                jz              .last_chunk
+.loop:
+                mov             r9, [r8 + 8 * r11]
+                inc             r11
+                cmp             r11, rcx
+                je              .last_chunk
+                mov             rbx, MAX_CHUNK_DIGITS
+.full_chunk_loop:
+                call            .write_digit
+                dec             rbx
+                jnz             .full_chunk_loop
+                jmp             .loop
+
+.last_chunk:
+                call            .write_digit
+                test            r9, r9
+                jnz             .last_chunk
+
+                mov             rdx, rbp
+                sub             rdx, rsi
+                call            print_string
+
+                pop             rax
+                call            heap_release
+
+                pop             r11
+                pop             r10
+                pop             r9
+                pop             r8
+                pop             rbp
+                pop             rcx
+                pop             rax
+                ret
+
+; puts the lowest decimal digit of r9 before rsi, r9 = r9 / 10
+; division by 10 is done by multiplication by DIV10_MAGIC (r10)
+.write_digit:
+                mov             rax, r9
+                mul             r10
+                shr             rdx, 3
+                lea             rax, [rdx + 4 * rdx]
+                add             rax, rax
+                sub             r9, rax
+                add             r9, '0'
+                dec             rsi
+                mov             [rsi], r9b
+                mov             r9, rdx
+                ret
+
+; write long number to stdout in hexadecimal with 0x prefix
+;    rdi -- argument (long number)
+;    rcx -- length of long number in qwords
+write_hex_long:
+                push            rax
+                push            rcx
+                push            r8
+                push            r9
+
+                mov             al, '0'
+                call            write_char
+                mov             al, 'x'
+                call            write_char
+                test            rcx, rcx
+                jz              .zero
+
+; the highest qword is written without leading zeros
+                mov             r9, [rdi + 8 * rcx - 8]
+                bsr             r8, r9
+                shr             r8, 2
+                inc             r8
+                call            .write_qword
+.loop:
+                dec             rcx
+                jz              .done
+                mov             r9, [rdi + 8 * rcx - 8]
+                mov             r8, QWORD_HEX_DIGITS
+                call            .write_qword
+                jmp             .loop
+
+.zero:
+                mov             al, '0'
+                call            write_char
+.done:
+                pop             r9
+                pop             r8
+                pop             rcx
+                pop             rax
+                ret
+
+; writes r8 lowest hexadecimal digits of r9
+.write_qword:
+                push            rcx
+                lea             rcx, [4 * r8]
+                neg             cl
+                rol             r9, cl
+.digit_loop:
+                rol             r9, 4
+                mov             eax, r9d
+                and             eax, 15
+                mov             al, [hex_digits + rax]
+                call            write_char
+                dec             r8
+                jnz             .digit_loop
+                pop             rcx
+                ret
+
+; write long number to stdout in binary: length and qwords
+;    rdi -- argument (long number)
+;    rcx -- length of long number in qwords
+write_binary_long:
+                push            rdx
+                push            rsi
+
+; negative number has the highest bit of length set
+                mov             rdx, rcx
+                cmp             byte [binary_negative], 0
+                je              .positive
+                bts             rdx, 63
+                mov             byte [binary_negative], 0
+.positive:
+                mov             [binary_length], rdx
+                mov             rsi, binary_length
+                mov             rdx, 8
+                call            print_string
+                mov             rsi, rdi
+                lea             rdx, [8 * rcx]
+                call            print_string
+
+                pop             rsi
+                pop             rdx
+                ret
+
+; writes minus before a negative number, in binary format the highest bit
+; of length of the next number is set instead
+write_minus:
+                cmp             byte [io_format], FORMAT_BINARY
+                je              .binary
+                push            rax
+                mov             al, '-'
+                call            write_char
+                pop             rax
+                ret
+
+.binary:
+                mov             byte [binary_negative], 1
+                ret
+
+; ends line after a written number, binary numbers are not separated
+write_line_end:
+                cmp             byte [io_format], FORMAT_BINARY
+                je              .done
+                push            rax
+                mov             al, 0x0a
+                call            write_char
+                pop             rax
+.done:
+                ret
+
+; read one char from stdin
+; if stdin is a regular file it is mapped to memory and chars are taken
+; right from the mapping, otherwise stdin is read by blocks of IN_BUF_SIZE
+; bytes, so most calls are served from memory without a syscall; output
+; is flushed before reading, so results of previous input are never held
+; back
+; result:
+;    rax == -1 if error occurs
+;    rax \in [0; 255] if OK
+read_char:
+                mov             rax, [in_pos]
+                cmp             rax, [in_end]
+                jae             .refill
+.get:
+                add             rax, [in_data]
+                movzx           eax, byte [rax]
+                inc             qword [in_pos]
+                ret
+
+.refill:
+                cmp             byte [in_mode], IN_MAPPED
+                je              .error
+
+                push            rcx
+                push            rdx
+                push            rsi
+                push            rdi
+                push            r11
+
+                call            flush_output
+
+                cmp             byte [in_mode], IN_UNKNOWN
+                jne             .read
+                call            map_input
+                cmp             byte [in_mode], IN_MAPPED
+                jne             .read
+
+                pop             r11
+                pop             rdi
+                pop             rsi
+                pop             rdx
+                pop             rcx
+                jmp             read_char
+
+.read:
+                xor             rax, rax
+                xor             rdi, rdi
+                mov             rsi, in_buf
+                mov             rdx, IN_BUF_SIZE
+                syscall
+
+                pop             r11
+                pop             rdi
+                pop             rsi
+                pop             rdx
+                pop             rcx
+
+                cmp             rax, 0
+                jle             .error
+                mov             [in_end], rax
+                xor             rax, rax
+                mov             [in_pos], rax
+                jmp             .get
+.error:
+                mov             rax, -1
+                ret
+
+; read block of bytes from stdin
+;    rdi -- address of block
+;    rcx -- size of block in bytes
+; result:
+;    CF=1 if input has ended before the end of block
+read_block:
+                push            rax
+                push            rcx
+                push            rsi
+                push            rdi
+
+.loop:
+                test            rcx, rcx
+                jz              .done
+                mov             rax, [in_end]
+                sub             rax, [in_pos]
+                jnz             .copy
+; nothing is left in memory, next char comes with a refill
+                call            read_char
+                test            rax, rax
+                js              .end_of_input
+                stosb
+                dec             rcx
+                jmp             .loop
+
+.copy:
+                cmp             rax, rcx
+                cmova           rax, rcx
+                mov             rsi, [in_data]
+                add             rsi, [in_pos]
+                add             [in_pos], rax
+                sub             rcx, rax
+                push            rcx
+                mov             rcx, rax
+                rep movsb
+                pop             rcx
+                jmp             .loop
+
+.done:
+                pop             rdi
+                pop             rsi
+                pop             rcx
+                pop             rax
+                clc
+                ret
+
+.end_of_input:
+                pop             rdi
+                pop             rsi
+                pop             rcx
+                pop             rax
+                stc
+                ret
+
+; maps the rest of stdin to memory if it is a regular file
+; result:
+;    in_mode is IN_MAPPED and in_data, in_pos, in_end describe the mapping
+;    if stdin is mapped, in_mode is IN_STREAM otherwise
+map_input:
+                push            rax
+                push            rbx
+                push            rcx
+                push            rdx
+                push            rsi
+                push            rdi
+                push            r8
+                push            r9
+                push            r10
+                push            r11
+                sub             rsp, STAT_BUF_SIZE
+
+                mov             byte [in_mode], IN_STREAM
+
+                mov             rax, 5
+                xor             rdi, rdi
+                mov             rsi, rsp
+                syscall
+                test            rax, rax
+                jnz             .done
+                mov             eax, [rsp + STAT_MODE]
+                and             eax, S_IFMT
+                cmp             eax, S_IFREG
+                jne             .done
+
+; stdin may be partially read already, mapping starts at its offset
+                mov             rax, 8
+                xor             rdi, rdi
+                xor             rsi, rsi
+                mov             rdx, SEEK_CUR
+                syscall
+                test            rax, rax
+                js              .done
+                mov             rbx, rax
+                cmp             rbx, [rsp + STAT_SIZE]
+                jae             .done
+
+                mov             rax, 9
+                xor             rdi, rdi
+                mov             rsi, [rsp + STAT_SIZE]
+                mov             rdx, PROT_READ
+                mov             r10, MAP_PRIVATE
+                xor             r8, r8
+                xor             r9, r9
+                syscall
+                cmp             rax, -4095
+                jae             .done
+
+                mov             [in_data], rax
+                mov             [in_pos], rbx
+                mov             rax, [rsp + STAT_SIZE]
+                mov             [in_end], rax
+                mov             byte [in_mode], IN_MAPPED
+
+.done:
+                add             rsp, STAT_BUF_SIZE
+                pop             r11
+                pop             r10
+                pop             r9
+                pop             r8
+                pop             rdi
+                pop             rsi
+                pop             rdx
+                pop             rcx
+                pop             rbx
+                pop             rax
+                ret
+
+; write one char to stdout, errors are ignored
+; chars are collected in out_buf, see flush_output
+;    al -- char
+write_char:
+                push            rdi
+
+                mov             rdi, [out_pos]
+                cmp             rdi, OUT_BUF_SIZE
+                jb              .put
+                call            flush_output
+                xor             rdi, rdi
+.put:
+                mov             [out_buf + rdi], al
+                inc             rdi
+                mov             [out_pos], rdi
+
+                pop             rdi
+                ret
+
+; makes read_char take the rest of input from memory instead of stdin
+;    rsi -- address of input
+;    rdx -- size of input
+read_from_memory:
+                mov             [in_data], rsi
+                mov             qword [in_pos], 0
+                mov             [in_end], rdx
+                mov             byte [in_mode], IN_MAPPED
+                ret
+
+; flushes output buffer and sends further output to another file
+;    rax -- file descriptor
+redirect_output:
+                call            flush_output
+                mov             [out_fd], rax
+                ret
+
+; flushes output buffer and terminates the program
+exit:
+                call            flush_output
+
+                mov             rax, 60
+                xor             rdi, rdi
+                syscall
+
+; print string to stdout, errors are ignored
+; string is copied to out_buf, strings longer than the buffer are
+; written directly
+;    rsi -- string
+;    rdx -- size
+print_string:
+                push            rax
+                push            rcx
+                push            rsi
+                push            rdi
+
+                mov             rax, OUT_BUF_SIZE
+                sub             rax, [out_pos]
+                cmp             rdx, rax
+                jbe             .copy
+                call            flush_output
+                cmp             rdx, OUT_BUF_SIZE
+                jbe             .copy
+                call            write_all
+                jmp             .done
+
+.copy:
+                mov             rdi, [out_pos]
+                add             [out_pos], rdx
+                add             rdi, out_buf
+                mov             rcx, rdx
+                rep movsb
+
+.done:
+                pop             rdi
+                pop             rsi
+                pop             rcx
+                pop             rax
+                ret
+
+; writes content of output buffer to stdout, errors are ignored
+flush_output:
+                push            rsi
+                push            rdx
+
+                mov             rsi, out_buf
+                mov             rdx, [out_pos]
+                call            write_all
+                mov             qword [out_pos], 0
+
+                pop             rdx
+                pop             rsi
+                ret
+
+; write memory block to stdout (out_fd), errors are ignored
+;    rsi -- address
+;    rdx -- size
+write_all:
+                push            rax
+                push            rcx
+                push            rdx
+                push            rsi
+                push            rdi
+                push            r11
+
+.loop:
+                test            rdx, rdx
+                jz              .done
+                mov             rax, 1
+                mov             rdi, [out_fd]
+                syscall
+                cmp             rax, 0
+                jle             .done
+                add             rsi, rax
+                sub             rdx, rax
+                jmp             .loop
+
+.done:
+                pop             r11
+                pop             rdi
+                pop             rsi
+                pop             rdx
+                pop             rcx
+                pop             rax
+                ret
+
+
+                section         .rodata
+invalid_char_msg:
+                db              "Invalid character: "
+invalid_char_msg_size: equ             $ - invalid_char_msg
+invalid_length_msg:
+                db              "Invalid length of binary number", 0x0a
+invalid_length_msg_size: equ           $ - invalid_length_msg
+unknown_option_msg:
+                db              "Unknown option: "
+unknown_option_msg_size: equ           $ - unknown_option_msg
+hex_digits:     db              "0123456789abcdef"
+
+                align           8
+; powers of ten from 10^0 to 10^MAX_CHUNK_DIGITS
+pow10:
+                dq              1
+                dq              10
+                dq              100
+                dq              1000
+                dq              10000
+                dq              100000
+                dq              1000000
+                dq              10000000
+                dq              100000000
+                dq              1000000000
+                dq              10000000000
+                dq              100000000000
+                dq              1000000000000
+                dq              10000000000000
+                dq              100000000000000
+                dq              1000000000000000
+                dq              10000000000000000
+                dq              100000000000000000
+                dq              1000000000000000000
+                dq              10000000000000000000
+
+                section         .data
+; chars of stdin that are in memory, in_buf or mapping of stdin
+in_data:        dq              in_buf
+; file descriptor of output, see redirect_output
+out_fd:         dq              1
+
+                section         .bss
+in_buf:         resb            IN_BUF_SIZE
+; position of the next unread char in in_data
+in_pos:         resq            1
+; number of valid chars in in_data
+in_end:         resq            1
+; how stdin is read, see IN_UNKNOWN
+in_mode:        resb            1
+out_buf:        resb            OUT_BUF_SIZE
+; number of chars waiting in out_buf
+out_pos:        resq            1
+; length of number for write_binary_long
+binary_length:  resq            1
+; format of numbers, see FORMAT_DECIMAL
+io_format:      resb            1
+; numbers are written in hexadecimal, the last number read was hexadecimal
+hex_output:     resb            1
+; the next binary number is negative, see write_minus
+binary_negative: resb           1
@@ -0,0 +1,725 @@
+; long arithmetic helpers shared by add, sub and mul
+;
+; long number is an array of qwords, least significant qword first;
+; its length never counts leading zero qwords, so zero has length 0
+                section         .text
+
+                global          add_n
+                global          sub_n
+                global          add_long_long
+                global          add_long_short
+                global          sub_long_long
+                global          compare_long
+                global          mul_1
+                global          mul_long_short
+                global          div_long_short
+                global          div_long_short_preinv
+                global          reciprocal_short
+                global          set_zero
+                global          is_zero
+                global          copy_long
+                global          normalize_long
+
+                extern          has_avx2
+
+; adds (adc) or subtracts (sbb) qword of rdx to (from) qword of rsi
+; at index r9 + %2 and writes it to rdi, uses rax
+%macro LIMB_OP 2
+                mov             rax, [rsi + 8 * r9 + 8 * %2]
+                %1              rax, [rdx + 8 * r9 + 8 * %2]
+                mov             [rdi + 8 * r9 + 8 * %2], rax
+%endmacro
+
+; splits length for carry chain: r11 -- number of single qwords,
+; rbx -- number of blocks of 4 qwords (0 or 1),
+; r10 -- number of blocks of 8 qwords
+%macro SPLIT_LENGTH 1
+                mov             r11, %1
+                and             r11, 3
+                mov             rbx, %1
+                shr             rbx, 2
+                and             rbx, 1
+                mov             r10, %1
+                shr             r10, 3
+%endmacro
+
+; body of add_n (adc) and sub_n (sbb): qwords are processed by 1, then 4,
+; then 8 per iteration; loop control uses only lea, inc and dec, which
+; keep CF
+%macro ADD_SUB_N 1
+                push            rbx
+                push            r9
+                push            r10
+                push            r11
+
+                SPLIT_LENGTH    rcx
+; clears CF
+                xor             r9, r9
+                inc             r11
+                dec             r11
+                jz              .by_4
+.by_1:
+                LIMB_OP         %1, 0
+                lea             r9, [r9 + 1]
+                dec             r11
+                jnz             .by_1
+.by_4:
+                inc             rbx
+                dec             rbx
+                jz              .by_8
+                LIMB_OP         %1, 0
+                LIMB_OP         %1, 1
+                LIMB_OP         %1, 2
+                LIMB_OP         %1, 3
+                lea             r9, [r9 + 4]
+.by_8:
+                inc             r10
+                dec             r10
+                jz              .done
+.loop:
+                LIMB_OP         %1, 0
+                LIMB_OP         %1, 1
+                LIMB_OP         %1, 2
+                LIMB_OP         %1, 3
+                LIMB_OP         %1, 4
+                LIMB_OP         %1, 5
+                LIMB_OP         %1, 6
+                LIMB_OP         %1, 7
+                lea             r9, [r9 + 8]
+                dec             r10
+                jnz             .loop
+
+.done:
+                setc            al
+                movzx           rax, al
+
+                pop             r11
+                pop             r10
+                pop             r9
+                pop             rbx
+                ret
+%endmacro
+
+; adds two fixed-length numbers
+;    rdi -- address of sum, rcx qwords, may be equal to rsi or rdx
+;    rsi -- address of summand #1, rcx qwords
+;    rdx -- address of summand #2, rcx qwords
+;    rcx -- length of all numbers in qwords, may be 0
+; result:
+;    rcx qwords of sum are written to rdi
+;    rax -- carry (0 or 1)
+add_n:
+                ADD_SUB_N       adc
+
+; subtracts fixed-length number from fixed-length number, see add_n for
+; arguments (rdi = rsi - rdx)
+; result:
+;    rcx qwords of difference are written to rdi
+;    rax -- borrow (0 or 1)
+sub_n:
+                ADD_SUB_N       sbb
+
+; adds two long numbers
+;    rdi -- address of summand #1 (long number)
+;    rcx -- length of summand #1 in qwords
+;    rsi -- address of summand #2 (long number)
+;    rdx -- length of summand #2 in qwords
+; result:
+;    sum is written to rdi, there should be room for max(rcx, rdx) + 1 qwords
+;    rcx -- length of sum in qwords
+add_long_long:
+                push            rax
+                push            r8
+                push            r9
+                push            r10
+
+; common qwords are added by add_n, r9 -- their number
+                mov             r8, rcx
+                cmp             rcx, rdx
+                cmova           rcx, rdx
+                mov             r9, rcx
+                push            rdx
+                push            rsi
+                mov             rdx, rsi
+                mov             rsi, rdi
+                call            add_n
+                pop             rsi
+                pop             rdx
+
+                mov             rcx, r8
+                cmp             rcx, rdx
+                cmovb           rcx, rdx
+; summand #2 is longer, copy the rest of it
+.copy_loop:
+                cmp             r9, rdx
+                jae             .carry_loop
+                mov             r10, [rsi + 8 * r9]
+                add             r10, rax
+                setc            al
+                mov             [rdi + 8 * r9], r10
+                inc             r9
+                jmp             .copy_loop
+
+; propagate carry through summand #1
+.carry_loop:
+                test            rax, rax
+                jz              .done
+                cmp             r9, r8
+                jae             .new_qword
+                add             qword [rdi + 8 * r9], 1
+                setc            al
+                inc             r9
+                jmp             .carry_loop
+
+.new_qword:
+                mov             [rdi + 8 * rcx], rax
+                inc             rcx
+
+.done:
+                pop             r10
+                pop             r9
+                pop             r8
+                pop             rax
+                ret
+
+; subtracts long number from long number
+;    rdi -- address of minuend (long number)
+;    rcx -- length of minuend in qwords
+;    rsi -- address of subtrahend (long number)
+;    rdx -- length of subtrahend in qwords
+;    minuend should not be less than subtrahend and rcx >= rdx
+; result:
+;    difference is written to rdi
+;    rcx -- length of difference in qwords
+sub_long_long:
+                push            rax
+                push            rcx
+                push            rdx
+                push            rsi
+                push            r9
+
+; common qwords are subtracted by sub_n, r9 -- their number
+                mov             rcx, rdx
+                mov             r9, rdx
+                mov             rdx, rsi
+                mov             rsi, rdi
+                call            sub_n
+
+; borrow goes on only while it is set, the rest of minuend is the rest
+; of difference already
+                bt              rax, 0
+.borrow_loop:
+                jnc             .done
+                sub             qword [rdi + 8 * r9], 1
+                inc             r9
+                jmp             .borrow_loop
+
+.done:
+                pop             r9
+                pop             rsi
+                pop             rdx
+                pop             rcx
+                call            normalize_long
+
+                pop             rax
+                ret
+
+; compares two long numbers, qwords are compared from the highest one
+; until the first difference
+;    rdi -- address of number #1 (long number)
+;    rcx -- length of number #1 in qwords
+;    rsi -- address of number #2 (long number)
+;    rdx -- length of number #2 in qwords
+; result:
+;    flags as after unsigned cmp of number #1 and number #2
+compare_long:
+                cmp             rcx, rdx
+                jne             .done
+                push            rax
+                push            rcx
+
+.loop:
+                test            rcx, rcx
+                jz              .compared
+                mov             rax, [rdi + 8 * rcx - 8]
+                cmp             rax, [rsi + 8 * rcx - 8]
+                jne             .compared
+                dec             rcx
+                jmp             .loop
+
+.compared:
+                pop             rcx
+                pop             rax
+.done:
+                ret
+
+; adds 64-bit number to long number
+;    rdi -- address of summand #1 (long number)
+;    rcx -- length of summand #1 in qwords
+;    rax -- summand #2 (64-bit unsigned)
+; result:
+;    sum is written to rdi, there should be room for rcx + 1 qwords
+;    rcx -- length of sum in qwords
+add_long_short:
+                push            rax
+                push            rdx
+
+                xor             rdx, rdx
+.loop:
+                cmp             rdx, rcx
+                jae             .new_qword
+                add             [rdi + 8 * rdx], rax
+                jnc             .done
+                mov             rax, 1
+                inc             rdx
+                jmp             .loop
+
+.new_qword:
+                test            rax, rax
+                jz              .done
+                mov             [rdi + 8 * rcx], rax
+                inc             rcx
+
+.done:
+                pop             rdx
+                pop             rax
+                ret
+
+; multiplies a fixed-length number by a short
+;    rdi -- address of product, rcx qwords, may be equal to rsi
+;    rsi -- address of multiplier #1, rcx qwords
+;    rcx -- length of both numbers in qwords, may be 0
+;    rbx -- multiplier #2 (64-bit unsigned)
+; result:
+;    rcx qwords of product are written to rdi
+;    rax -- high qword, the product is rdi + rax * 2^(64 * rcx)
+mul_1:
+                push            rdx
+                push            r8
+                push            r9
+
+; r8 -- carry, r9 -- index
+                xor             r8, r8
+                xor             r9, r9
+                test            rcx, rcx
+                jz              .done
+.loop:
+                mov             rax, [rsi + 8 * r9]
+                mul             rbx
+                add             rax, r8
+                adc             rdx, 0
+                mov             [rdi + 8 * r9], rax
+                mov             r8, rdx
+                inc             r9
+                cmp             r9, rcx
+                jb              .loop
+
+.done:
+                mov             rax, r8
+
+                pop             r9
+                pop             r8
+                pop             rdx
+                ret
+
+; multiplies long number by a short
+;    rdi -- address of multiplier #1 (long number)
+;    rcx -- length of multiplier #1 in qwords
+;    rbx -- multiplier #2 (64-bit unsigned)
+; result:
+;    product is written to rdi, there should be room for rcx + 1 qwords
+;    rcx -- length of product in qwords
+mul_long_short:
+                test            rbx, rbx
+                jnz             .nonzero
+                xor             rcx, rcx
+                ret
+
+.nonzero:
+                push            rax
+                push            rsi
+
+                mov             rsi, rdi
+                call            mul_1
+                test            rax, rax
+                jz              .done
+                mov             [rdi + 8 * rcx], rax
+                inc             rcx
+
+.done:
+                pop             rsi
+                pop             rax
+                ret
+
+; divides long number by a short
+;    rdi -- address of dividend (long number)
+;    rcx -- length of dividend in qwords
+;    rbx -- divisor (64-bit unsigned)
+; result:
+;    quotient is written to rdi
+;    rcx -- length of quotient in qwords
+;    rdx -- remainder
+div_long_short:
+                push            rax
+                push            r8
+
+                xor             rdx, rdx
+                mov             r8, rcx
+                test            r8, r8
+                jz              .done
+.loop:
+                mov             rax, [rdi + 8 * r8 - 8]
+                div             rbx
+                mov             [rdi + 8 * r8 - 8], rax
+                dec             r8
+                jnz             .loop
+
+; quotient is at most one qword shorter than dividend
+                cmp             qword [rdi + 8 * rcx - 8], 0
+                jne             .done
+                dec             rcx
+
+.done:
+                pop             r8
+                pop             rax
+                ret
+
+; divides long number by a short with a precomputed reciprocal
+; (Moller, Granlund "Improved division by invariant integers"), every
+; qword takes two multiplications instead of div
+;    rdi -- address of dividend (long number)
+;    rcx -- length of dividend in qwords
+;    rbx -- divisor (64-bit unsigned), the highest bit should be set
+;    r8 -- reciprocal of divisor (see reciprocal_short)
+; result:
+;    quotient is written to rdi
+;    rcx -- length of quotient in qwords
+;    rdx -- remainder
+div_long_short_preinv:
+                push            rax
+                push            r9
+                push            r10
+                push            r11
+                push            r12
+
+; r10 -- remainder (high qword of the current 2-qword dividend),
+; r11 -- next qword of the dividend
+                xor             r10, r10
+                mov             r9, rcx
+                test            r9, r9
+                jz              .done
+.loop:
+                mov             r11, [rdi + 8 * r9 - 8]
+
+; quotient candidate is the high qword of r10:r11 + r10 * r8 + 2^64
+                mov             rax, r10
+                mul             r8
+                add             rax, r11
+                adc             rdx, r10
+                inc             rdx
+                mov             r12, rax
+
+; remainder candidate r11 - rdx * rbx, it is corrected by adding divisor
+; if it is greater than the low qword of the sum above
+                mov             rax, rdx
+                imul            rax, rbx
+                sub             r11, rax
+                lea             rax, [r11 + rbx]
+                cmp             r12, r11
+                cmovb           r11, rax
+                sbb             rdx, 0
+
+; second correction is unlikely
+                cmp             r11, rbx
+                jae             .adjust
+.next:
+                mov             [rdi + 8 * r9 - 8], rdx
+                mov             r10, r11
+                dec             r9
+                jnz             .loop
+
+; quotient is at most one qword shorter than dividend
+                cmp             qword [rdi + 8 * rcx - 8], 0
+                jne             .done
+                dec             rcx
+
+.done:
+                mov             rdx, r10
+
+                pop             r12
+                pop             r11
+                pop             r10
+                pop             r9
+                pop             rax
+                ret
+
+.adjust:
+                inc             rdx
+                sub             r11, rbx
+                jmp             .next
+
+; computes reciprocal of a short for div_long_short_preinv
+;    rbx -- divisor (64-bit unsigned), the highest bit should be set
+; result:
+;    r8 -- floor((2^128 - 1) / rbx) - 2^64
+reciprocal_short:
+                push            rax
+                push            rdx
+
+                mov             rdx, rbx
+                not             rdx
+                mov             rax, -1
+                div             rbx
+                mov             r8, rax
+
+                pop             rdx
+                pop             rax
+                ret
+
+; set_zero, is_zero and copy_long jump through kernel pointers; kernels
+; are selected on the first call of any of them: loops of 32-byte vmovdqu
+; (vpor and vptest for is_zero) if the cpu and the os support AVX2, and
+; rep stosq, scasq and movsq otherwise; AVX2 kernels change ymm0 and ymm1,
+; copy_long_avx2 copies by 128 bytes, so the destination may overlap the
+; source only if it is not above it
+
+; assigns a zero to long number
+;    rdi -- argument (long number)
+;    rcx -- length of long number in qwords
+set_zero:
+                jmp             [rel set_zero_kernel]
+
+; checks if a long number is a zero
+;    rdi -- argument (long number)
+;    rcx -- length of long number in qwords
+; result:
+;    ZF=1 if zero
+is_zero:
+                jmp             [rel is_zero_kernel]
+
+; copies long number, qwords are copied from the lowest one
+;    rdi -- destination (long number)
+;    rsi -- source (long number)
+;    rcx -- length of long number in qwords
+copy_long:
+                jmp             [rel copy_long_kernel]
+
+; select kernels and run the called one
+set_zero_detect:
+                call            select_kernels
+                jmp             [rel set_zero_kernel]
+
+is_zero_detect:
+                call            select_kernels
+                jmp             [rel is_zero_kernel]
+
+copy_long_detect:
+                call            select_kernels
+                jmp             [rel copy_long_kernel]
+
+select_kernels:
+                push            rax
+
+                call            has_avx2
+                test            rax, rax
+                jz              .string
+                lea             rax, [rel set_zero_avx2]
+                mov             [rel set_zero_kernel], rax
+                lea             rax, [rel is_zero_avx2]
+                mov             [rel is_zero_kernel], rax
+                lea             rax, [rel copy_long_avx2]
+                mov             [rel copy_long_kernel], rax
+                jmp             .selected
+
+.string:
+                lea             rax, [rel set_zero_stosq]
+                mov             [rel set_zero_kernel], rax
+                lea             rax, [rel is_zero_scasq]
+                mov             [rel is_zero_kernel], rax
+                lea             rax, [rel copy_long_movsq]
+                mov             [rel copy_long_kernel], rax
+
+.selected:
+                pop             rax
+                ret
+
+set_zero_stosq:
+                push            rax
+                push            rdi
+                push            rcx
+
+                xor             rax, rax
+                rep stosq
+
+                pop             rcx
+                pop             rdi
+                pop             rax
+                ret
+
+is_zero_scasq:
+                push            rax
+                push            rdi
+                push            rcx
+
+                xor             rax, rax
+                rep scasq
+
+                pop             rcx
+                pop             rdi
+                pop             rax
+                ret
+
+copy_long_movsq:
+                push            rsi
+                push            rdi
+                push            rcx
+
+                rep movsq
+
+                pop             rcx
+                pop             rdi
+                pop             rsi
+                ret
+
+; AVX2 kernels take 16 qwords (4 ymm registers) per iteration, stores are
+; aligned to 32 bytes by single qwords first; the rest (less than 16 qwords)
+; is done by string instructions; vzeroupper avoids the penalty of legacy
+; SSE code after them
+set_zero_avx2:
+                push            rax
+                push            rdi
+                push            rcx
+
+                xor             rax, rax
+.align:
+                test            rdi, 31
+                jz              .aligned
+                test            rcx, rcx
+                jz              .done
+                mov             [rdi], rax
+                add             rdi, 8
+                dec             rcx
+                jmp             .align
+.aligned:
+                vpxor           xmm0, xmm0, xmm0
+                sub             rcx, 16
+                jb              .rest
+.loop:
+                vmovdqa         [rdi], ymm0
+                vmovdqa         [rdi + 32], ymm0
+                vmovdqa         [rdi + 64], ymm0
+                vmovdqa         [rdi + 96], ymm0
+                sub             rdi, -128
+                sub             rcx, 16
+                jae             .loop
+.rest:
+                add             rcx, 16
+                rep stosq
+                vzeroupper
+
+.done:
+                pop             rcx
+                pop             rdi
+                pop             rax
+                ret
+
+is_zero_avx2:
+                push            rax
+                push            rdi
+                push            rcx
+
+                sub             rcx, 16
+                jb              .rest
+.loop:
+                vmovdqu         ymm0, [rdi]
+                vmovdqu         ymm1, [rdi + 32]
+                vpor            ymm0, ymm0, [rdi + 64]
+                vpor            ymm1, ymm1, [rdi + 96]
+                vpor            ymm0, ymm0, ymm1
+                vptest          ymm0, ymm0
+                jnz             .done
+                sub             rdi, -128
+                sub             rcx, 16
+                jae             .loop
+.rest:
+                add             rcx, 16
+                xor             rax, rax
+                rep scasq
+.done:
+                vzeroupper
+
+                pop             rcx
+                pop             rdi
+                pop             rax
+                ret
+
+copy_long_avx2:
+                push            rax
+                push            rsi
+                push            rdi
+                push            rcx
+
+.align:
+                test            rdi, 31
+                jz              .aligned
+                test            rcx, rcx
+                jz              .done
+                mov             rax, [rsi]
+                mov             [rdi], rax
+                add             rsi, 8
+                add             rdi, 8
+                dec             rcx
+                jmp             .align
+.aligned:
+                sub             rcx, 16
+                jb              .rest
+.loop:
+                vmovdqu         ymm0, [rsi]
+                vmovdqu         ymm1, [rsi + 32]
+                vmovdqa         [rdi], ymm0
+                vmovdqa         [rdi + 32], ymm1
+                vmovdqu         ymm0, [rsi + 64]
+                vmovdqu         ymm1, [rsi + 96]
+                vmovdqa         [rdi + 64], ymm0
+                vmovdqa         [rdi + 96], ymm1
+                sub             rsi, -128
+                sub             rdi, -128
+                sub             rcx, 16
+                jae             .loop
+.rest:
+                add             rcx, 16
+                rep movsq
+                vzeroupper
+
+.done:
+                pop             rcx
+                pop             rdi
+                pop             rsi
+                pop             rax
+                ret
+
+; removes leading zero qwords from length of long number
+;    rdi -- address of long number
+;    rcx -- length of long number in qwords
+; result:
+;    rcx -- length of long number without leading zeros
+normalize_long:
+                test            rcx, rcx
+                jz              .done
+                cmp             qword [rdi + 8 * rcx - 8], 0
+                jne             .done
+                dec             rcx
+                jmp             normalize_long
+
+.done:
+                ret
+
+
+                section         .data
+; current kernels of set_zero, is_zero and copy_long
+set_zero_kernel: dq             set_zero_detect
+is_zero_kernel: dq              is_zero_detect
+copy_long_kernel: dq            copy_long_detect
+
+; long_c links this file into C programs, which need no executable stack
+                section         .note.GNU-stack noalloc noexec nowrite progbits
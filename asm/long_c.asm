@@ -0,0 +1,212 @@
+; long arithmetic for C programs, see long_c.h
+;
+; routines follow the System V AMD64 calling convention; long numbers are
+; arrays of qwords (limbs), least significant qword first, of a fixed
+; length n, they are not normalized; most routines are shims which move
+; arguments to the registers of the kernels of long.asm and mul_long.asm
+                section         .text
+
+                global          long_add_n
+                global          long_sub_n
+                global          long_mul_1
+                global          long_addmul_1
+                global          long_submul_1
+                global          long_divrem_1
+                global          long_lshift
+                global          long_rshift
+                global          long_sqr
+
+                extern          add_n
+                extern          sub_n
+                extern          mul_1
+                extern          addmul_1
+                extern          submul_1
+                extern          copy_long
+                extern          div_long_short
+                extern          sqr_long
+                extern          mul_scratch_length
+                extern          malloc
+                extern          free
+                extern          abort
+
+; long_sqr takes scratch space of at most this many bytes from the stack
+SQR_STACK_SCRATCH: equ          1 << 16
+
+; uint64_t long_add_n(uint64_t *rp, const uint64_t *up,
+;                     const uint64_t *vp, size_t n)
+; arguments are already where add_n takes them
+long_add_n:
+                jmp             add_n
+
+; uint64_t long_sub_n(uint64_t *rp, const uint64_t *up,
+;                     const uint64_t *vp, size_t n)
+long_sub_n:
+                jmp             sub_n
+
+; calls a kernel taking the short in rbx and the length in rcx, rbx is
+; callee-saved in C
+%macro MUL_1_SHIM 1
+                push            rbx
+                mov             rbx, rcx
+                mov             rcx, rdx
+                call            %1
+                pop             rbx
+                ret
+%endmacro
+
+; uint64_t long_mul_1(uint64_t *rp, const uint64_t *up, size_t n,
+;                     uint64_t v)
+long_mul_1:
+                MUL_1_SHIM      mul_1
+
+; uint64_t long_addmul_1(uint64_t *rp, const uint64_t *up, size_t n,
+;                        uint64_t v)
+long_addmul_1:
+                MUL_1_SHIM      addmul_1
+
+; uint64_t long_submul_1(uint64_t *rp, const uint64_t *up, size_t n,
+;                        uint64_t v)
+long_submul_1:
+                MUL_1_SHIM      submul_1
+
+; uint64_t long_divrem_1(uint64_t *qp, const uint64_t *up, size_t n,
+;                        uint64_t d)
+; dividend is copied to qp and divided there in place
+long_divrem_1:
+                push            rbx
+                mov             rbx, rcx
+                mov             rcx, rdx
+                cmp             rdi, rsi
+                je              .divide
+                call            copy_long
+.divide:
+                call            div_long_short
+                mov             rax, rdx
+                pop             rbx
+                ret
+
+; uint64_t long_lshift(uint64_t *rp, const uint64_t *up, size_t n,
+;                      unsigned cnt)
+; qwords are shifted from the most significant one, r8 -- current qword
+long_lshift:
+                mov             r8, [rsi + 8 * rdx - 8]
+                xor             eax, eax
+                shld            rax, r8, cl
+                dec             rdx
+                jz              .last
+.loop:
+                mov             r9, [rsi + 8 * rdx - 8]
+                shld            r8, r9, cl
+                mov             [rdi + 8 * rdx], r8
+                mov             r8, r9
+                dec             rdx
+                jnz             .loop
+.last:
+                shl             r8, cl
+                mov             [rdi], r8
+                ret
+
+; uint64_t long_rshift(uint64_t *rp, const uint64_t *up, size_t n,
+;                      unsigned cnt)
+; qwords are shifted from the least significant one, r8 -- current qword,
+; r10 -- its index
+long_rshift:
+                mov             r8, [rsi]
+                xor             eax, eax
+                shrd            rax, r8, cl
+                xor             r10d, r10d
+                dec             rdx
+                jz              .last
+.loop:
+                mov             r9, [rsi + 8 * r10 + 8]
+                shrd            r8, r9, cl
+                mov             [rdi + 8 * r10], r8
+                mov             r8, r9
+                inc             r10
+                dec             rdx
+                jnz             .loop
+.last:
+                shr             r8, cl
+                mov             [rdi + 8 * r10], r8
+                ret
+
+; void long_sqr(uint64_t *rp, const uint64_t *up, size_t n)
+; square is computed by sqr_long; its scratch space and n more qwords for
+; a copy of up, if up overlaps rp, are taken from the stack up to
+; SQR_STACK_SCRATCH bytes and with malloc otherwise;
+; rbx -- rp, r12 -- up, r13 -- n, r14 -- scratch space,
+; rbp -- stack pointer after saving registers
+long_sqr:
+                test            rdx, rdx
+                jz              .done
+                push            rbp
+                push            rbx
+                push            r12
+                push            r13
+                push            r14
+                mov             rbp, rsp
+                mov             rbx, rdi
+                mov             r12, rsi
+                mov             r13, rdx
+
+                mov             rcx, rdx
+                call            mul_scratch_length
+                add             rax, r13
+                shl             rax, 3
+                and             rsp, -16
+                cmp             rax, SQR_STACK_SCRATCH
+                ja              .heap
+                sub             rsp, rax
+                and             rsp, -16
+                mov             r14, rsp
+                call            .square
+                jmp             .return
+
+.heap:
+                mov             rdi, rax
+                call            malloc wrt ..plt
+                test            rax, rax
+                jz              .no_memory
+                mov             r14, rax
+                call            .square
+                mov             rdi, r14
+                call            free wrt ..plt
+
+.return:
+                mov             rsp, rbp
+                pop             r14
+                pop             r13
+                pop             r12
+                pop             rbx
+                pop             rbp
+.done:
+                ret
+
+.no_memory:
+                call            abort wrt ..plt
+
+; up overlaps rp if up < rp + 2n and rp < up + n, then it is copied to
+; the start of scratch space
+.square:
+                mov             rdi, rbx
+                mov             rsi, r12
+                mov             rcx, r13
+                mov             r8, r14
+                lea             rax, [rbx + 8 * r13]
+                lea             rax, [rax + 8 * r13]
+                cmp             r12, rax
+                jae             .separate
+                lea             rax, [r12 + 8 * r13]
+                cmp             rbx, rax
+                jae             .separate
+
+                mov             rdi, r14
+                call            copy_long
+                mov             rdi, rbx
+                mov             rsi, r14
+                lea             r8, [r14 + 8 * r13]
+.separate:
+                jmp             sqr_long
+
+; the library does not need an executable stack
+                section         .note.GNU-stack noalloc noexec nowrite progbits
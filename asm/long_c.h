@@ -0,0 +1,60 @@
+#ifndef LONG_C_H
+#define LONG_C_H
+
+/*
+ * long arithmetic routines of long_c.asm (library long_c)
+ *
+ * long numbers are arrays of n limbs, least significant limb first;
+ * n may be zero unless said otherwise, results of n limbs are written to rp
+ * or qp, which may be equal to up (and vp)
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* rp = up + vp, returns carry (0 or 1) */
+uint64_t long_add_n(uint64_t *rp, const uint64_t *up, const uint64_t *vp, size_t n);
+
+/* rp = up - vp, returns borrow (0 or 1) */
+uint64_t long_sub_n(uint64_t *rp, const uint64_t *up, const uint64_t *vp, size_t n);
+
+/* rp = up * v, returns the most significant limb of the product */
+uint64_t long_mul_1(uint64_t *rp, const uint64_t *up, size_t n, uint64_t v);
+
+/* rp += up * v, returns the carry limb; rp must not overlap up */
+uint64_t long_addmul_1(uint64_t *rp, const uint64_t *up, size_t n, uint64_t v);
+
+/* rp -= up * v, returns the borrow limb; rp must not overlap up */
+uint64_t long_submul_1(uint64_t *rp, const uint64_t *up, size_t n, uint64_t v);
+
+/* qp = up / d, returns up % d; d must not be zero */
+uint64_t long_divrem_1(uint64_t *qp, const uint64_t *up, size_t n, uint64_t d);
+
+/*
+ * rp = up << cnt, returns bits shifted out in the low bits of the result;
+ * n >= 1, 1 <= cnt <= 63, rp >= up if they overlap
+ */
+uint64_t long_lshift(uint64_t *rp, const uint64_t *up, size_t n, unsigned cnt);
+
+/*
+ * rp = up >> cnt, returns bits shifted out in the high bits of the result;
+ * n >= 1, 1 <= cnt <= 63, rp <= up if they overlap
+ */
+uint64_t long_rshift(uint64_t *rp, const uint64_t *up, size_t n, unsigned cnt);
+
+/*
+ * rp[0 .. 2n) = up^2, rp may overlap up; scratch space is taken from the
+ * stack, up to 64 KiB, or with malloc for large n, abort is called if
+ * malloc fails
+ */
+void long_sqr(uint64_t *rp, const uint64_t *up, size_t n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LONG_C_H */
@@ -0,0 +1,97 @@
+; heap for long numbers
+;
+; memory is taken from the kernel with brk and given out sequentially, so
+; the last allocated number can be extended by further allocations;
+; memory is released all at once back to a mark (see heap_mark)
+                section         .text
+
+                global          alloc_long
+                global          heap_mark
+                global          heap_release
+
+                extern          print_string
+                extern          exit
+
+; break is moved by at least HEAP_STEP bytes at once
+HEAP_STEP:      equ             1 << 20
+
+; allocates memory for long number at the top of the heap
+;    rcx -- length of long number in qwords
+; result:
+;    rax -- address of allocated memory
+alloc_long:
+                push            rcx
+                push            rdx
+                push            rsi
+                push            rdi
+                push            r11
+
+                mov             rax, [heap_top]
+                test            rax, rax
+                jnz             .initialized
+                mov             rax, 12
+                xor             rdi, rdi
+                syscall
+                mov             [heap_top], rax
+                mov             [heap_end], rax
+; syscall has overwritten rcx with the return address
+                mov             rcx, [rsp + 32]
+
+.initialized:
+                lea             rdx, [rax + 8 * rcx]
+                cmp             rdx, [heap_end]
+                jbe             .done
+
+                lea             rdi, [rdx + HEAP_STEP]
+                mov             rax, 12
+                syscall
+                cmp             rax, rdi
+                jb              .out_of_memory
+                mov             [heap_end], rax
+                mov             rax, [heap_top]
+
+.done:
+                mov             [heap_top], rdx
+
+                pop             r11
+                pop             rdi
+                pop             rsi
+                pop             rdx
+                pop             rcx
+                ret
+
+.out_of_memory:
+                mov             rsi, out_of_memory_msg
+                mov             rdx, out_of_memory_msg_size
+                call            print_string
+                jmp             exit
+
+; returns current top of the heap
+; result:
+;    rax -- mark to be passed to heap_release
+heap_mark:
+                push            rcx
+
+                xor             rcx, rcx
+                call            alloc_long
+
+                pop             rcx
+                ret
+
+; releases all memory allocated after the mark
+;    rax -- mark returned by heap_mark
+heap_release:
+                mov             [heap_top], rax
+                ret
+
+
+                section         .rodata
+out_of_memory_msg:
+                db              "Out of memory", 0x0a
+out_of_memory_msg_size: equ     $ - out_of_memory_msg
+
+                section         .bss
+; first free byte of the heap
+heap_top:       resq            1
+; current program break
+heap_end:       resq            1
@@ -0,0 +1,55 @@
+; prints products of pairs of long numbers until the end of input
+                section         .text
+
+                extern          mul_long_long
+                extern          mul_scratch_length
+                extern          alloc_long
+                extern          heap_mark
+                extern          heap_release
+                extern          read_long
+                extern          write_long
+                extern          write_line_end
+                extern          parse_args
+                extern          exit
+
+                global          _start
+_start:
+                mov             rdi, rsp
+                call            parse_args
+
+.next_pair:
+                call            heap_mark
+                push            rax
+
+                call            read_long
+                jc              .done
+                mov             rsi, rdi
+                mov             r8, rcx
+                call            read_long
+                jc              .done
+                mov             rbx, rdi
+                mov             rdx, rcx
+                mov             rcx, r8
+
+                push            rcx
+                call            mul_scratch_length
+                mov             rcx, rax
+                call            alloc_long
+                mov             r8, rax
+                mov             rcx, [rsp]
+                add             rcx, rdx
+                call            alloc_long
+                mov             rdi, rax
+                pop             rcx
+                call            mul_long_long
+
+                call            write_long
+
+                call            write_line_end
+
+                pop             rax
+                call            heap_release
+                jmp             .next_pair
+
+.done:
+                jmp             exit
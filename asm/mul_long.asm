@@ -0,0 +1,728 @@
+; multiplication of long numbers
+;
+; long numbers are multiplied by Karatsuba's method down to
+; KARATSUBA_THRESHOLD qwords, smaller products are computed by rows;
+; squares are computed separately, every cross product is computed once
+; and then doubled, Karatsuba's method is used down to
+; SQR_KARATSUBA_THRESHOLD qwords;
+; the row kernel is selected on the first call: rows are computed with
+; mulx and two independent carry chains (adcx/adox) if the cpu supports
+; BMI2 and ADX, and with mul/adc otherwise; the mul/adc kernel is the fused
+; multiply-accumulate loop of addmul_1, which adds every product to the row
+; in memory without a separate addition pass
+                section         .text
+
+                global          mul_long_long
+                global          sqr_long
+                global          mul_scratch_length
+                global          addmul_1
+                global          submul_1
+
+                extern          has_bmi2_adx
+                extern          add_long_long
+                extern          sub_long_long
+                extern          copy_long
+                extern          normalize_long
+                extern          set_zero
+
+; products of numbers shorter than KARATSUBA_THRESHOLD qwords are computed
+; by rows, it should be at least 4; can be set with -DKARATSUBA_THRESHOLD=n
+%ifndef KARATSUBA_THRESHOLD
+%define KARATSUBA_THRESHOLD 32
+%endif
+; same for squares, it should be at least 4 too; cross products are computed
+; once by rows, so squares switch to Karatsuba's method later than products;
+; can be set with -DSQR_KARATSUBA_THRESHOLD=n
+%ifndef SQR_KARATSUBA_THRESHOLD
+%define SQR_KARATSUBA_THRESHOLD 48
+%endif
+; scratch space needed above 4 * (rcx + rdx) qwords, covers the extra
+; qwords of all recursion levels
+MUL_SCRATCH_EXTRA: equ          1024
+
+; adds (add) or subtracts (sub) product of qword of rsi and r13 to (from)
+; qword of r12 at index rcx + %2, carry qword is taken from and left in r8;
+; the qword of r12 is added before the carry, so only one addition is on
+; the carry chain; uses rax, rdx and r9
+%macro MUL_1_LIMB 2
+                mov             rax, [rsi + 8 * rcx + 8 * %2]
+                mul             r13
+                mov             r9, [r12 + 8 * rcx + 8 * %2]
+                %1              r9, rax
+                adc             rdx, 0
+                %1              r9, r8
+                adc             rdx, 0
+                mov             [r12 + 8 * rcx + 8 * %2], r9
+                mov             r8, rdx
+%endmacro
+
+; adds (add) or subtracts (sub) rsi * r13 to (from) r12 for indices
+; r10 .. -1, r10 <= 0, rsi and r12 point to ends of the numbers; qwords
+; are processed by 1 until the index is a multiple of 4, then 4 per
+; iteration; carry qword is left in r8, uses rax, rcx, rdx and r9
+%macro MUL_1_ROW 1
+                mov             rcx, r10
+                xor             r8, r8
+                test            cl, 3
+                jz              %%by_4
+%%by_1:
+                MUL_1_LIMB      %1, 0
+                inc             rcx
+                test            cl, 3
+                jnz             %%by_1
+%%by_4:
+                test            rcx, rcx
+                jz              %%done
+%%loop:
+                MUL_1_LIMB      %1, 0
+                MUL_1_LIMB      %1, 1
+                MUL_1_LIMB      %1, 2
+                MUL_1_LIMB      %1, 3
+                add             rcx, 4
+                jnz             %%loop
+%%done:
+%endmacro
+
+; body of addmul_1 (add) and submul_1 (sub)
+%macro MUL_1 1
+                push            rcx
+                push            rdx
+                push            rsi
+                push            r8
+                push            r9
+                push            r10
+                push            r12
+                push            r13
+
+                lea             rsi, [rsi + 8 * rcx]
+                lea             r12, [rdi + 8 * rcx]
+                mov             r10, rcx
+                neg             r10
+                mov             r13, rbx
+                MUL_1_ROW       %1
+                mov             rax, r8
+
+                pop             r13
+                pop             r12
+                pop             r10
+                pop             r9
+                pop             r8
+                pop             rsi
+                pop             rdx
+                pop             rcx
+                ret
+%endmacro
+
+; multiplies two long numbers
+;    rdi -- address of product (long number), there should be room for
+;           rcx + rdx qwords, product must not overlap multipliers
+;    rsi -- address of multiplier #1 (long number)
+;    rcx -- length of multiplier #1 in qwords
+;    rbx -- address of multiplier #2 (long number)
+;    rdx -- length of multiplier #2 in qwords
+;    r8 -- address of scratch space of 4 * (rcx + rdx) + MUL_SCRATCH_EXTRA
+;          qwords, only used if both lengths reach KARATSUBA_THRESHOLD
+; result:
+;    product is written to rdi
+;    rcx -- length of product in qwords
+; equal multipliers are squared (see sqr_long)
+mul_long_long:
+                test            rcx, rcx
+                jz              .zero
+                test            rdx, rdx
+                jnz             .nonzero
+.zero:
+                xor             rcx, rcx
+                ret
+
+.nonzero:
+                cmp             rcx, rdx
+                jne             .product
+                cmp             rsi, rbx
+                je              sqr_long
+                call            .compare
+                je              sqr_long
+
+.product:
+                push            rbx
+                push            rdx
+                push            rsi
+
+                cmp             rcx, rdx
+                jae             .ordered
+                xchg            rsi, rbx
+                xchg            rcx, rdx
+.ordered:
+                call            karatsuba
+
+                add             rcx, rdx
+                cmp             qword [rdi + 8 * rcx - 8], 0
+                jne             .done
+                dec             rcx
+
+.done:
+                pop             rsi
+                pop             rdx
+                pop             rbx
+                ret
+
+; compares multipliers of equal length, ZF=1 if they are equal
+.compare:
+                push            rcx
+                push            rsi
+                push            rdi
+
+                mov             rdi, rbx
+                repe cmpsq
+
+                pop             rdi
+                pop             rsi
+                pop             rcx
+                ret
+
+; squares a long number
+;    rdi -- address of square (long number), there should be room for
+;           2 * rcx qwords, square must not overlap argument
+;    rsi -- address of argument (long number)
+;    rcx -- length of argument in qwords
+;    r8 -- address of scratch space, see mul_long_long (rdx = rcx)
+; result:
+;    square is written to rdi
+;    rcx -- length of square in qwords
+sqr_long:
+                test            rcx, rcx
+                jz              .done
+
+                call            karatsuba_sqr
+
+                add             rcx, rcx
+                cmp             qword [rdi + 8 * rcx - 8], 0
+                jne             .done
+                dec             rcx
+
+.done:
+                ret
+
+; adds product of a fixed-length number and a short to a fixed-length number
+;    rdi -- address of summand, rcx qwords
+;    rsi -- address of multiplier #1, rcx qwords, must not overlap rdi
+;           unless it is equal to rdi
+;    rcx -- length of both numbers in qwords, may be 0
+;    rbx -- multiplier #2 (64-bit unsigned)
+; result:
+;    rcx qwords of sum are written to rdi
+;    rax -- carry qword, the sum is rdi + rax * 2^(64 * rcx)
+addmul_1:
+                MUL_1           add
+
+; subtracts product of a fixed-length number and a short from a fixed-length
+; number, see addmul_1 for arguments
+; result:
+;    rcx qwords of difference are written to rdi
+;    rax -- borrow qword, the difference is rdi - rax * 2^(64 * rcx)
+submul_1:
+                MUL_1           sub
+
+; computes size of scratch space for mul_long_long
+;    rcx -- length of multiplier #1 in qwords
+;    rdx -- length of multiplier #2 in qwords
+; result:
+;    rax -- length of scratch space in qwords
+mul_scratch_length:
+                lea             rax, [rcx + rdx]
+                lea             rax, [4 * rax + MUL_SCRATCH_EXTRA]
+                ret
+
+; multiplies long numbers by Karatsuba's method, falls back to
+; mul_basecase below KARATSUBA_THRESHOLD qwords
+;    rdi -- address of product, there should be room for rcx + rdx qwords
+;    rsi -- address of multiplier #1 (long number)
+;    rcx -- length of multiplier #1 in qwords
+;    rbx -- address of multiplier #2 (long number)
+;    rdx -- length of multiplier #2 in qwords, rcx >= rdx >= 1
+;    r8 -- address of scratch space, see mul_long_long
+; result:
+;    rcx + rdx qwords of product are written to rdi, leading zeros included
+karatsuba:
+                cmp             rdx, KARATSUBA_THRESHOLD
+                jb              mul_basecase
+
+                push            rax
+                push            rbx
+                push            rcx
+                push            rdx
+                push            rsi
+                push            rdi
+                push            r8
+                push            r9
+                push            r10
+                push            r11
+                push            r12
+                push            r13
+                push            r14
+                push            r15
+
+; r9 -- product, r12 / r13 -- multiplier #1 and its length,
+; r14 / r15 -- multiplier #2 and its length, r10 -- length of low halves
+                mov             r9, rdi
+                mov             r12, rsi
+                mov             r13, rcx
+                mov             r14, rbx
+                mov             r15, rdx
+                lea             r10, [rcx + 1]
+                shr             r10, 1
+                cmp             r15, r10
+                jbe             .unbalanced
+
+; multiplier #1 = u1 * B^r10 + u0, multiplier #2 = v1 * B^r10 + v0
+; z0 = u0 * v0 is written to the low part of the product
+                mov             rcx, r10
+                mov             rdx, r10
+                call            karatsuba
+
+; z2 = u1 * v1 is written to the high part of the product
+                lea             rdi, [r9 + 8 * r10]
+                lea             rdi, [rdi + 8 * r10]
+                lea             rsi, [r12 + 8 * r10]
+                mov             rcx, r13
+                sub             rcx, r10
+                lea             rbx, [r14 + 8 * r10]
+                mov             rdx, r15
+                sub             rdx, r10
+                call            karatsuba
+
+; u0 + u1 and v0 + v1 take r10 + 1 qwords each at the start of scratch space
+                mov             r11, r8
+                mov             rdi, r11
+                mov             rsi, r12
+                mov             rcx, r10
+                call            copy_long
+                mov             qword [rdi + 8 * r10], 0
+                lea             rsi, [r12 + 8 * r10]
+                mov             rdx, r13
+                sub             rdx, r10
+                call            add_long_long
+
+                lea             rdi, [r11 + 8 * r10 + 8]
+                mov             rsi, r14
+                mov             rcx, r10
+                call            copy_long
+                mov             qword [rdi + 8 * r10], 0
+                lea             rsi, [r14 + 8 * r10]
+                mov             rdx, r15
+                sub             rdx, r10
+                call            add_long_long
+
+; z1 = (u0 + u1) * (v0 + v1) takes next 2 * r10 + 2 qwords
+                mov             rbx, rdi
+                mov             rsi, r11
+                lea             rcx, [r10 + 1]
+                mov             rdx, rcx
+                lea             rdi, [rbx + 8 * r10 + 8]
+                lea             r8, [rdi + 8 * r10 + 8]
+                lea             r8, [r8 + 8 * r10 + 8]
+                call            karatsuba
+
+; z1 = z1 - z0 - z2 = u0 * v1 + u1 * v0
+                add             rcx, rcx
+                mov             rsi, r9
+                lea             rdx, [r10 + r10]
+                call            sub_normalized
+                lea             rsi, [r9 + 8 * r10]
+                lea             rsi, [rsi + 8 * r10]
+                lea             rdx, [r13 + r15]
+                sub             rdx, r10
+                sub             rdx, r10
+                call            sub_normalized
+
+; product += z1 * B^r10
+                mov             rsi, rdi
+                mov             rdx, rcx
+                lea             rdi, [r9 + 8 * r10]
+                lea             rcx, [r13 + r15]
+                sub             rcx, r10
+                call            add_long_long
+                jmp             .done
+
+; multiplier #1 is at least twice longer, it is multiplied by pieces of
+; r15 qwords; r10 -- offset of the current piece, r11 -- its length
+.unbalanced:
+                mov             rcx, r15
+                call            karatsuba
+
+                mov             r10, r15
+.piece:
+                cmp             r10, r13
+                jae             .done
+                mov             r11, r13
+                sub             r11, r10
+                cmp             r11, r15
+                cmova           r11, r15
+
+; part of the product that is already computed is saved to scratch space
+                mov             rdi, r8
+                lea             rsi, [r9 + 8 * r10]
+                mov             rcx, r15
+                call            copy_long
+
+                lea             rdi, [r9 + 8 * r10]
+                mov             rsi, r14
+                mov             rcx, r15
+                lea             rbx, [r12 + 8 * r10]
+                mov             rdx, r11
+                push            r8
+                lea             r8, [r8 + 8 * r15]
+                call            karatsuba
+                pop             r8
+
+                lea             rcx, [r15 + r11]
+                mov             rsi, r8
+                mov             rdx, r15
+                call            add_long_long
+
+                add             r10, r15
+                jmp             .piece
+
+.done:
+                pop             r15
+                pop             r14
+                pop             r13
+                pop             r12
+                pop             r11
+                pop             r10
+                pop             r9
+                pop             r8
+                pop             rdi
+                pop             rsi
+                pop             rdx
+                pop             rcx
+                pop             rbx
+                pop             rax
+                ret
+
+; rdi -= rsi, where subtrahend is normalized first (see sub_long_long)
+sub_normalized:
+                xchg            rsi, rdi
+                xchg            rdx, rcx
+                call            normalize_long
+                xchg            rsi, rdi
+                xchg            rdx, rcx
+                jmp             sub_long_long
+
+; squares long number by Karatsuba's method, falls back to sqr_basecase
+; below SQR_KARATSUBA_THRESHOLD qwords
+;    rdi -- address of square, there should be room for 2 * rcx qwords
+;    rsi -- address of argument (long number)
+;    rcx -- length of argument in qwords, rcx >= 1
+;    r8 -- address of scratch space, see mul_long_long
+; result:
+;    2 * rcx qwords of square are written to rdi, leading zeros included
+karatsuba_sqr:
+                cmp             rcx, SQR_KARATSUBA_THRESHOLD
+                jb              sqr_basecase
+
+                push            rax
+                push            rbx
+                push            rcx
+                push            rdx
+                push            rsi
+                push            rdi
+                push            r8
+                push            r9
+                push            r10
+                push            r11
+                push            r12
+                push            r13
+
+; r9 -- square, r12 / r13 -- argument and its length,
+; r10 -- length of the low half
+                mov             r9, rdi
+                mov             r12, rsi
+                mov             r13, rcx
+                lea             r10, [rcx + 1]
+                shr             r10, 1
+
+; argument = u1 * B^r10 + u0
+; z0 = u0^2 is written to the low part of the square
+                mov             rcx, r10
+                call            karatsuba_sqr
+
+; z2 = u1^2 is written to the high part of the square
+                lea             rdi, [r9 + 8 * r10]
+                lea             rdi, [rdi + 8 * r10]
+                lea             rsi, [r12 + 8 * r10]
+                mov             rcx, r13
+                sub             rcx, r10
+                call            karatsuba_sqr
+
+; u0 + u1 takes r10 + 1 qwords at the start of scratch space
+                mov             r11, r8
+                mov             rdi, r11
+                mov             rsi, r12
+                mov             rcx, r10
+                call            copy_long
+                mov             qword [rdi + 8 * r10], 0
+                lea             rsi, [r12 + 8 * r10]
+                mov             rdx, r13
+                sub             rdx, r10
+                call            add_long_long
+
+; z1 = (u0 + u1)^2 takes next 2 * r10 + 2 qwords
+                mov             rsi, r11
+                lea             rcx, [r10 + 1]
+                lea             rdi, [r11 + 8 * r10 + 8]
+                lea             r8, [rdi + 8 * r10 + 8]
+                lea             r8, [r8 + 8 * r10 + 8]
+                call            karatsuba_sqr
+
+; z1 = z1 - z0 - z2 = 2 * u0 * u1
+                add             rcx, rcx
+                mov             rsi, r9
+                lea             rdx, [r10 + r10]
+                call            sub_normalized
+                lea             rsi, [r9 + 8 * r10]
+                lea             rsi, [rsi + 8 * r10]
+                lea             rdx, [r13 + r13]
+                sub             rdx, r10
+                sub             rdx, r10
+                call            sub_normalized
+
+; square += z1 * B^r10
+                mov             rsi, rdi
+                mov             rdx, rcx
+                lea             rdi, [r9 + 8 * r10]
+                lea             rcx, [r13 + r13]
+                sub             rcx, r10
+                call            add_long_long
+
+                pop             r13
+                pop             r12
+                pop             r11
+                pop             r10
+                pop             r9
+                pop             r8
+                pop             rdi
+                pop             rsi
+                pop             rdx
+                pop             rcx
+                pop             rbx
+                pop             rax
+                ret
+
+; multiplies long numbers by rows
+;    rdi -- address of product, there should be room for rcx + rdx qwords
+;    rsi -- address of multiplier #1 (long number)
+;    rcx -- length of multiplier #1 in qwords
+;    rbx -- address of multiplier #2 (long number)
+;    rdx -- length of multiplier #2 in qwords, rcx >= rdx >= 1
+; result:
+;    rcx + rdx qwords of product are written to rdi, leading zeros included
+mul_basecase:
+                push            rax
+                push            rbx
+                push            rcx
+                push            rdx
+                push            rsi
+                push            r8
+                push            r9
+                push            r10
+                push            r11
+                push            r12
+                push            r13
+
+; only the first row is added to memory that was not written yet
+                call            set_zero
+
+; r10 -- minus length of multiplier #1, rows are indexed from r10 to 0
+; rsi -- end of multiplier #1
+; r12 -- end of the current row of the product
+; rbx -- current qword of multiplier #2, r11 -- number of rows left
+                mov             r10, rcx
+                neg             r10
+                lea             rsi, [rsi + 8 * rcx]
+                lea             r12, [rdi + 8 * rcx]
+                mov             r11, rdx
+                call            [rel mul_row_kernel]
+
+                pop             r13
+                pop             r12
+                pop             r11
+                pop             r10
+                pop             r9
+                pop             r8
+                pop             rsi
+                pop             rdx
+                pop             rcx
+                pop             rbx
+                pop             rax
+                ret
+
+; squares long number by rows: every cross product u[i] * u[j], i < j, is
+; computed once by the row kernel, their sum is doubled by a shift and
+; squares u[i]^2 are added
+;    rdi -- address of square, there should be room for 2 * rcx qwords
+;    rsi -- address of argument (long number)
+;    rcx -- length of argument in qwords, rcx >= 1
+; result:
+;    2 * rcx qwords of square are written to rdi, leading zeros included
+sqr_basecase:
+                push            rax
+                push            rbx
+                push            rcx
+                push            rdx
+                push            rsi
+                push            r8
+                push            r9
+                push            r10
+                push            r11
+                push            r12
+                push            r13
+                push            r14
+
+                mov             r14, rcx
+                add             rcx, rcx
+                call            set_zero
+
+; row i adds u[i + 1 ..] * u[i] to the square from qword 2 * i + 1, so
+; rows get shorter by one qword and the row kernel is run for one row at
+; a time; it advances rbx and r12 to the next row itself
+; r10 -- minus length of the row, rsi -- end of argument,
+; r12 -- end of the row, rbx -- u[i]
+                mov             rbx, rsi
+                lea             rsi, [rsi + 8 * r14]
+                lea             r12, [rdi + 8 * r14]
+                lea             r10, [r14 - 1]
+                neg             r10
+.row:
+                test            r10, r10
+                jz              .double
+                mov             r11, 1
+                call            [rel mul_row_kernel]
+                inc             r10
+                jmp             .row
+
+; sum of cross products is shifted left by one bit, two qwords per
+; iteration; loop control keeps CF
+.double:
+                mov             rcx, r14
+                xor             r9, r9
+.double_loop:
+                mov             rax, [rdi + 8 * r9]
+                adc             rax, rax
+                mov             [rdi + 8 * r9], rax
+                mov             rax, [rdi + 8 * r9 + 8]
+                adc             rax, rax
+                mov             [rdi + 8 * r9 + 8], rax
+                lea             r9, [r9 + 2]
+                dec             rcx
+                jnz             .double_loop
+
+; u[i]^2 is added to qwords 2 * i and 2 * i + 1, r9 -- carry
+                mov             rbx, r14
+                neg             rbx
+                lea             rbx, [rsi + 8 * rbx]
+                mov             r10, rdi
+                xor             r9, r9
+                xor             rcx, rcx
+.diagonal:
+                mov             rax, [rbx + 8 * rcx]
+                mul             rax
+                add             rax, r9
+                adc             rdx, 0
+                add             [r10], rax
+                adc             [r10 + 8], rdx
+                setc            r9b
+                movzx           r9, r9b
+                add             r10, 16
+                inc             rcx
+                cmp             rcx, r14
+                jb              .diagonal
+
+                pop             r14
+                pop             r13
+                pop             r12
+                pop             r11
+                pop             r10
+                pop             r9
+                pop             r8
+                pop             rsi
+                pop             rdx
+                pop             rcx
+                pop             rbx
+                pop             rax
+                ret
+
+; row kernels, see mul_long_long for register usage
+; every row adds multiplier #1 times a qword of multiplier #2 to the product
+; rax, rcx, rdx, r8, r9, r13 are not preserved
+
+; selects row kernel and runs it
+mul_rows_detect:
+                call            has_bmi2_adx
+                test            rax, rax
+                lea             rax, [rel mul_rows_mulx]
+                jnz             .selected
+                lea             rax, [rel mul_rows_mul]
+.selected:
+                mov             [rel mul_row_kernel], rax
+                jmp             rax
+
+; rows with mul/adc, see MUL_1_ROW, carry is kept in r8
+mul_rows_mul:
+.row:
+                mov             r13, [rbx]
+                MUL_1_ROW       add
+                mov             [r12], r8
+                add             rbx, 8
+                add             r12, 8
+                dec             r11
+                jnz             .row
+                ret
+
+; rows with mulx, high halves of products are added through CF (adcx),
+; the row of the product is added through OF (adox); loop control uses
+; lea and jrcxz, which keep both flags, two qwords per iteration
+mul_rows_mulx:
+.row:
+                mov             rdx, [rbx]
+                mov             rcx, r10
+; clears CF and OF
+                xor             r8d, r8d
+                test            r10b, 1
+                jz              .loop
+                mulx            r8, rax, [rsi + 8 * rcx]
+                adox            rax, [r12 + 8 * rcx]
+                mov             [r12 + 8 * rcx], rax
+                lea             rcx, [rcx + 1]
+                jrcxz           .row_done
+.loop:
+                mulx            r9, rax, [rsi + 8 * rcx]
+                adcx            rax, r8
+                adox            rax, [r12 + 8 * rcx]
+                mov             [r12 + 8 * rcx], rax
+                mulx            r8, rax, [rsi + 8 * rcx + 8]
+                adcx            rax, r9
+                adox            rax, [r12 + 8 * rcx + 8]
+                mov             [r12 + 8 * rcx + 8], rax
+                lea             rcx, [rcx + 2]
+                jrcxz           .row_done
+                jmp             .loop
+
+; rcx is zero here, both carries fit into the high half of the last product
+.row_done:
+                adcx            r8, rcx
+                adox            r8, rcx
+                mov             [r12], r8
+                add             rbx, 8
+                add             r12, 8
+                dec             r11
+                jnz             .row
+                ret
+
+
+                section         .data
+; current row kernel
+mul_row_kernel: dq              mul_rows_detect
+
+; long_c links this file into C programs, which need no executable stack
+                section         .note.GNU-stack noalloc noexec nowrite progbits
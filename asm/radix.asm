@@ -0,0 +1,714 @@
+; conversion of long numbers to and from base 10^19
+;
+; decimal digits are handled in chunks of 19 digits, a chunk is a qword
+; less than 10^19, an array of chunks is a long number in base 10^19;
+; 2^(k+1) chunks are joined from or split into halves of 2^k chunks with
+; P_k = 10^(19 * 2^k), powers are computed by squaring, P_k = P_(k-1)^2;
+; halves are joined by multiplication and split by division with
+; a precomputed reciprocal of P_k (Barrett's method), so conversion of n
+; qwords takes O(M(n) log n), where M(n) is the time of multiplication
+                section         .text
+
+                global          chunks_to_long
+                global          long_to_chunks
+
+                extern          add_long_long
+                extern          sub_long_long
+                extern          compare_long
+                extern          add_long_short
+                extern          mul_long_short
+                extern          div_long_short_preinv
+                extern          mul_long_long
+                extern          sqr_long
+                extern          mul_scratch_length
+                extern          copy_long
+                extern          set_zero
+                extern          normalize_long
+                extern          alloc_long
+                extern          heap_mark
+                extern          heap_release
+
+; 10^19, the base of chunks
+CHUNK_BASE:     equ             10000000000000000000
+; reciprocal of CHUNK_BASE for div_long_short_preinv,
+; floor((2^128 - 1) / 10^19) - 2^64; 10^19 has the highest bit set
+CHUNK_BASE_INV: equ             0xd83c94fb6d2ac34a
+; groups of JOIN_THRESHOLD chunks are joined one by one with
+; mul_long_short, it should be a power of two;
+; can be set with -DJOIN_THRESHOLD=n
+%ifndef JOIN_THRESHOLD
+%define JOIN_THRESHOLD 32
+%endif
+; numbers up to SPLIT_THRESHOLD qwords are split into chunks one by one
+; with div_long_short_preinv, it should be at least 2;
+; can be set with -DSPLIT_THRESHOLD=n
+%ifndef SPLIT_THRESHOLD
+%define SPLIT_THRESHOLD 128
+%endif
+; max number of powers P_k, P_47 has 19 * 2^47 digits
+MAX_POWERS:     equ             48
+
+; makes long number from chunks
+;    rsi -- address of chunks (long number in base 10^19)
+;    rcx -- number of chunks
+; result:
+;    rdi -- address of long number, it is allocated last with room for
+;           one more qword
+;    rcx -- length of long number in qwords
+chunks_to_long:
+                push            rax
+                push            rbx
+                push            rdx
+                push            rsi
+                push            r8
+                push            r9
+                push            r10
+                push            r11
+                push            r12
+                push            r13
+                push            r14
+                push            r15
+
+                cmp             rcx, JOIN_THRESHOLD
+                ja              .join
+                mov             r9, rcx
+                add             rcx, 2
+                call            alloc_long
+                mov             rdi, rax
+                call            .horner
+                jmp             .done
+
+; r12 -- address of chunks, r13 -- number of chunks,
+; r14 -- number of chunks rounded up to a power of two 2^r15
+.join:
+                mov             r12, rsi
+                mov             r13, rcx
+                mov             r14, 1
+                xor             r15, r15
+.round_up:
+                cmp             r14, r13
+                jae             .rounded
+                shl             r14, 1
+                inc             r15
+                jmp             .round_up
+.rounded:
+                xor             rbx, rbx
+.powers_loop:
+                call            make_power
+                inc             rbx
+                cmp             rbx, r15
+                jb              .powers_loop
+
+; r10 -- groups of 2^k chunks of the current level in slots of 2^k qwords,
+; r11 -- the next level, r8 -- scratch space for all products
+                mov             rcx, r14
+                call            alloc_long
+                mov             r10, rax
+                call            alloc_long
+                mov             r11, rax
+                shr             rcx, 1
+                mov             rdx, [pow_len + 8 * r15 - 8]
+                call            mul_scratch_length
+                mov             rcx, rax
+                call            alloc_long
+                mov             r8, rax
+
+; groups of JOIN_THRESHOLD chunks are joined one by one, rdx -- offset of
+; the current group, r9 -- number of its chunks
+                xor             rdx, rdx
+.group:
+                mov             r9, r13
+                sub             r9, rdx
+                jnc             .group_length
+                xor             r9, r9
+.group_length:
+                mov             rax, JOIN_THRESHOLD
+                cmp             r9, rax
+                cmova           r9, rax
+                lea             rsi, [r12 + 8 * rdx]
+                lea             rdi, [r10 + 8 * rdx]
+                call            .horner
+                lea             rdi, [rdi + 8 * rcx]
+                neg             rcx
+                add             rcx, JOIN_THRESHOLD
+                call            set_zero
+                add             rdx, JOIN_THRESHOLD
+                cmp             rdx, r14
+                jb              .group
+
+; r12 -- k, r13 -- 2^k, r9 -- offset of the current pair of groups;
+; slot of a pair = high group * P_k + low group
+                mov             r13, JOIN_THRESHOLD
+                bsf             r12, r13
+.level:
+                xor             r9, r9
+.pair:
+                lea             rax, [r9 + r13]
+                lea             rsi, [r10 + 8 * rax]
+                mov             rcx, r13
+                call            normalize_chunks
+                mov             rbx, [pow_addr + 8 * r12]
+                mov             rdx, [pow_len + 8 * r12]
+                lea             rdi, [r11 + 8 * r9]
+                call            mul_long_long
+
+                lea             rsi, [r10 + 8 * r9]
+                push            rcx
+                mov             rcx, r13
+                call            normalize_chunks
+                mov             rdx, rcx
+                pop             rcx
+                call            add_long_long
+
+                lea             rdi, [rdi + 8 * rcx]
+                neg             rcx
+                lea             rcx, [rcx + 2 * r13]
+                call            set_zero
+
+                lea             r9, [r9 + 2 * r13]
+                cmp             r9, r14
+                jb              .pair
+
+                xchg            r10, r11
+                inc             r12
+                shl             r13, 1
+                cmp             r13, r14
+                jb              .level
+
+; the number is copied to the top of the heap
+                mov             rdi, r10
+                mov             rcx, r14
+                call            normalize_long
+                mov             rsi, rdi
+                push            rcx
+                inc             rcx
+                call            alloc_long
+                pop             rcx
+                mov             rdi, rax
+                call            copy_long
+
+.done:
+                pop             r15
+                pop             r14
+                pop             r13
+                pop             r12
+                pop             r11
+                pop             r10
+                pop             r9
+                pop             r8
+                pop             rsi
+                pop             rdx
+                pop             rbx
+                pop             rax
+                ret
+
+; joins r9 chunks at rsi one by one from the highest chunk,
+; number = number * 10^19 + chunk; there should be room for r9 qwords
+; at rdi, rcx -- length of the number, uses rax and rbx
+.horner:
+                push            r9
+
+                xor             rcx, rcx
+                mov             rbx, CHUNK_BASE
+.horner_loop:
+                test            r9, r9
+                jz              .horner_done
+                call            mul_long_short
+                mov             rax, [rsi + 8 * r9 - 8]
+                call            add_long_short
+                dec             r9
+                jmp             .horner_loop
+
+.horner_done:
+                pop             r9
+                ret
+
+; splits long number into chunks
+;    rdi -- address of long number, it is destroyed
+;    rcx -- length of long number in qwords
+; result:
+;    rsi -- address of chunks (long number in base 10^19), allocated at
+;           the heap
+;    rcx -- number of chunks
+long_to_chunks:
+                push            rax
+                push            rbx
+                push            rdx
+                push            rdi
+                push            r8
+                push            r9
+                push            r10
+                push            r11
+                push            r12
+                push            r13
+                push            r14
+                push            r15
+
+                cmp             rcx, SPLIT_THRESHOLD
+                ja              .split
+
+; chunks are remainders of division by 10^19, a qword gives at most
+; two chunks
+                push            rcx
+                lea             rcx, [2 * rcx]
+                call            alloc_long
+                pop             rcx
+                mov             rsi, rax
+                mov             rbx, CHUNK_BASE
+                mov             r8, CHUNK_BASE_INV
+                xor             r9, r9
+.chunk_loop:
+                test            rcx, rcx
+                jz              .chunks_done
+                call            div_long_short_preinv
+                mov             [rsi + 8 * r9], rdx
+                inc             r9
+                jmp             .chunk_loop
+.chunks_done:
+                mov             rcx, r9
+                jmp             .done
+
+; powers up to P_K, where 2 * (length of P_K - 1) >= rcx, so that the
+; number is less than P_K^2; r12 -- the number, r13 -- its length
+.split:
+                mov             r12, rdi
+                mov             r13, rcx
+                xor             rbx, rbx
+.powers_loop:
+                call            make_power
+                mov             rax, [pow_len + 8 * rbx]
+                dec             rax
+                add             rax, rax
+                cmp             rax, r13
+                jae             .powers_done
+                inc             rbx
+                jmp             .powers_loop
+.powers_done:
+                mov             r15, rbx
+                mov             rcx, r13
+                call            make_inverses
+
+; no product of split_chunks is longer than the number and two qwords
+                lea             rcx, [r13 + 2]
+                mov             rdx, rcx
+                call            mul_scratch_length
+                mov             rcx, rax
+                call            alloc_long
+                mov             [split_scratch], rax
+
+; 2^(K+1) chunks
+                mov             rcx, r15
+                mov             r14, 2
+                shl             r14, cl
+                mov             rcx, r14
+                call            alloc_long
+
+                mov             rdi, r12
+                mov             rcx, r13
+                mov             rdx, r15
+                mov             rsi, rax
+                call            split_chunks
+                mov             rdi, rsi
+                mov             rcx, r14
+                call            normalize_long
+
+.done:
+                pop             r15
+                pop             r14
+                pop             r13
+                pop             r12
+                pop             r11
+                pop             r10
+                pop             r9
+                pop             r8
+                pop             rdi
+                pop             rdx
+                pop             rbx
+                pop             rax
+                ret
+
+; removes leading zero qwords from length of long number at rsi
+;    rsi -- address of long number
+;    rcx -- length of long number in qwords
+; result:
+;    rcx -- length of long number without leading zeros
+normalize_chunks:
+                xchg            rsi, rdi
+                call            normalize_long
+                xchg            rsi, rdi
+                ret
+
+; computes P_k = P_(k-1)^2, P_0 = 10^19, and puts it to pow_addr and pow_len
+;    rbx -- k
+make_power:
+                push            rax
+                push            rcx
+                push            rdx
+                push            rsi
+                push            rdi
+                push            r8
+
+                test            rbx, rbx
+                jnz             .square
+                mov             rcx, 1
+                call            alloc_long
+                mov             rdx, CHUNK_BASE
+                mov             [rax], rdx
+                mov             [pow_addr], rax
+                mov             [pow_len], rcx
+                jmp             .done
+
+.square:
+                mov             rsi, [pow_addr + 8 * rbx - 8]
+                mov             rcx, [pow_len + 8 * rbx - 8]
+                mov             rdx, rcx
+                push            rcx
+                call            mul_scratch_length
+                mov             rcx, rax
+                call            alloc_long
+                mov             r8, rax
+                mov             rcx, [rsp]
+                add             rcx, rcx
+                call            alloc_long
+                mov             rdi, rax
+                pop             rcx
+                call            sqr_long
+                mov             [pow_addr + 8 * rbx], rdi
+                mov             [pow_len + 8 * rbx], rcx
+
+.done:
+                pop             r8
+                pop             rdi
+                pop             rsi
+                pop             rdx
+                pop             rcx
+                pop             rax
+                ret
+
+; computes reciprocals I_k of P_k for k = 0 .. r15 and puts them to
+; inv_addr, inv_len and inv_exp: I_k is about B^e_k / P_k, where B = 2^64,
+; with p_k + 3 qwords, p_k -- length of P_k; they are the highest qwords of
+; M_k, about B^E_k / P_k, kept with L + 1 qwords: M_0 = B^(L + 1) / 10^19,
+; M_(k+1) is M_k^2 without the lowest qwords; every squaring doubles the
+; relative error of M_k, so it stays below 2^(k + 1) / B^L; quotients by
+; P_k, k < r15, have at most p_k + 1 qwords, quotient by P_r15 has at most
+; n - p_r15 + 1, so L is taken a few qwords longer than both
+;    rcx -- length n of the number
+;    r15 -- the highest k
+make_inverses:
+                push            rax
+                push            rbx
+                push            rcx
+                push            rdx
+                push            rsi
+                push            rdi
+                push            r8
+                push            r9
+                push            r10
+                push            r11
+                push            r12
+                push            r13
+
+; r12 -- L, r9 -- M_k, r10 -- M_k^2, r8 -- scratch space for squares
+                mov             r12, [pow_len + 8 * r15 - 8]
+                add             r12, 3
+                mov             rax, rcx
+                sub             rax, [pow_len + 8 * r15]
+                add             rax, 4
+                cmp             r12, rax
+                cmovl           r12, rax
+                lea             rcx, [r12 + 2]
+                call            alloc_long
+                mov             r9, rax
+                lea             rcx, [2 * r12 + 2]
+                call            alloc_long
+                mov             r10, rax
+                lea             rcx, [r12 + 1]
+                mov             rdx, rcx
+                call            mul_scratch_length
+                mov             rcx, rax
+                call            alloc_long
+                mov             r8, rax
+
+                mov             rdi, r9
+                lea             rcx, [r12 + 2]
+                call            set_zero
+                mov             qword [rdi + 8 * r12 + 8], 1
+                mov             rbx, CHUNK_BASE
+                push            r8
+                mov             r8, CHUNK_BASE_INV
+                call            div_long_short_preinv
+                pop             r8
+
+; r11 -- E_k, r13 -- k
+                lea             r11, [r12 + 1]
+                xor             r13, r13
+.loop:
+; I_k -- min(L + 1, p_k + 3) highest qwords of M_k, rax -- dropped qwords
+                mov             rcx, [pow_len + 8 * r13]
+                add             rcx, 3
+                lea             rax, [r12 + 1]
+                cmp             rcx, rax
+                cmova           rcx, rax
+                sub             rax, rcx
+                lea             rsi, [r9 + 8 * rax]
+                mov             rdx, r11
+                sub             rdx, rax
+                mov             [inv_exp + 8 * r13], rdx
+                call            alloc_long
+                mov             rdi, rax
+                call            copy_long
+                mov             [inv_addr + 8 * r13], rdi
+                mov             [inv_len + 8 * r13], rcx
+
+                cmp             r13, r15
+                jae             .done
+; M_(k+1) = M_k^2 / B^d, E_(k+1) = 2 * E_k - d
+                mov             rdi, r10
+                mov             rsi, r9
+                lea             rcx, [r12 + 1]
+                call            sqr_long
+                sub             rcx, r12
+                dec             rcx
+                lea             rsi, [r10 + 8 * rcx]
+                add             r11, r11
+                sub             r11, rcx
+                mov             rdi, r9
+                lea             rcx, [r12 + 1]
+                call            copy_long
+                inc             r13
+                jmp             .loop
+
+.done:
+                pop             r13
+                pop             r12
+                pop             r11
+                pop             r10
+                pop             r9
+                pop             r8
+                pop             rdi
+                pop             rsi
+                pop             rdx
+                pop             rcx
+                pop             rbx
+                pop             rax
+                ret
+
+; splits a number less than P_k^2 into 2^(k+1) chunks; the number is
+; divided by P_k, the quotient q = number * I_k / B^e_k is within a few
+; units and is corrected by comparison of q * P_k with the number; the
+; remainder and the quotient are split recursively
+;    rdi -- address of number, it is destroyed
+;    rcx -- length of number in qwords
+;    rdx -- k
+;    rsi -- address of chunks
+split_chunks:
+                push            rax
+                push            rbx
+                push            rcx
+                push            rdx
+                push            rsi
+                push            rdi
+                push            r8
+                push            r9
+                push            r10
+                push            r11
+                push            r12
+                push            r13
+                push            r14
+                push            r15
+
+                cmp             rcx, SPLIT_THRESHOLD
+                ja              .divide
+
+; chunks are remainders of division by 10^19, r9 -- number of chunks left
+                push            rcx
+                mov             rcx, rdx
+                mov             r9, 2
+                shl             r9, cl
+                pop             rcx
+                mov             rbx, CHUNK_BASE
+                mov             r8, CHUNK_BASE_INV
+.chunk_loop:
+                call            div_long_short_preinv
+                mov             [rsi], rdx
+                add             rsi, 8
+                dec             r9
+                jnz             .chunk_loop
+                jmp             .done
+
+; r12, r13 -- number (the remainder), r14 -- k, r15 -- address of chunks,
+; r9, r10 -- quotient, r11 -- q * P_k
+.divide:
+                mov             r12, rdi
+                mov             r13, rcx
+                mov             r14, rdx
+                mov             r15, rsi
+                call            heap_mark
+                push            rax
+
+                xor             r10, r10
+                mov             rsi, [pow_addr + 8 * r14]
+                mov             rdx, [pow_len + 8 * r14]
+                call            compare_long
+                jb              .halves
+
+; q = (number / B^(p_k - 2)) * (I_k / B^s) / B^(e_k - p_k + 2 - s), only
+; h = n - p_k + 2 highest qwords of the number and of I_k are needed,
+; r10 -- s, qwords of I_k dropped; q is computed in a buffer with room for
+; one more qword
+                mov             rax, [pow_len + 8 * r14]
+                sub             rax, 2
+                lea             rsi, [r12 + 8 * rax]
+                sub             rcx, rax
+                mov             rdx, [inv_len + 8 * r14]
+                xor             r10, r10
+                cmp             rdx, rcx
+                jbe             .whole_inverse
+                mov             r10, rdx
+                sub             r10, rcx
+                mov             rdx, rcx
+.whole_inverse:
+                mov             rbx, [inv_addr + 8 * r14]
+                lea             rbx, [rbx + 8 * r10]
+                push            rcx
+                lea             rcx, [rcx + rdx + 1]
+                call            alloc_long
+                pop             rcx
+                mov             rdi, rax
+                mov             r8, [split_scratch]
+                call            mul_long_long
+                mov             rax, [inv_exp + 8 * r14]
+                sub             rax, [pow_len + 8 * r14]
+                add             rax, 2
+                sub             rax, r10
+                lea             r9, [rdi + 8 * rax]
+                mov             r10, rcx
+                sub             r10, rax
+                jae             .product
+                mov             r9, rdi
+                xor             r10, r10
+
+.product:
+                mov             rsi, r9
+                mov             rcx, r10
+                mov             rbx, [pow_addr + 8 * r14]
+                mov             rdx, [pow_len + 8 * r14]
+                push            rcx
+                add             rcx, rdx
+                call            alloc_long
+                pop             rcx
+                mov             rdi, rax
+                call            mul_long_long
+                mov             r11, rdi
+
+; q is too big while q * P_k > number
+.too_big:
+                mov             rsi, r12
+                mov             rdx, r13
+                call            compare_long
+                jbe             .not_too_big
+                mov             rsi, [pow_addr + 8 * r14]
+                mov             rdx, [pow_len + 8 * r14]
+                call            sub_long_long
+                push            rcx
+                mov             rdi, r9
+                mov             rcx, r10
+                call            decrement_long
+                mov             r10, rcx
+                pop             rcx
+                mov             rdi, r11
+                jmp             .too_big
+
+.not_too_big:
+                mov             rsi, r11
+                mov             rdx, rcx
+                mov             rdi, r12
+                mov             rcx, r13
+                call            sub_long_long
+                mov             r13, rcx
+
+; q is too small while remainder >= P_k
+.too_small:
+                mov             rsi, [pow_addr + 8 * r14]
+                mov             rdx, [pow_len + 8 * r14]
+                call            compare_long
+                jb              .halves
+                call            sub_long_long
+                mov             r13, rcx
+                mov             rdi, r9
+                mov             rcx, r10
+                mov             rax, 1
+                call            add_long_short
+                mov             r10, rcx
+                mov             rdi, r12
+                mov             rcx, r13
+                jmp             .too_small
+
+; low 2^k chunks from the remainder, high ones from the quotient
+.halves:
+                mov             rdi, r12
+                mov             rcx, r13
+                lea             rdx, [r14 - 1]
+                mov             rsi, r15
+                call            split_chunks
+                mov             rcx, r14
+                mov             rax, 1
+                shl             rax, cl
+                lea             rsi, [r15 + 8 * rax]
+                mov             rdi, r9
+                mov             rcx, r10
+                call            split_chunks
+
+                pop             rax
+                call            heap_release
+
+.done:
+                pop             r15
+                pop             r14
+                pop             r13
+                pop             r12
+                pop             r11
+                pop             r10
+                pop             r9
+                pop             r8
+                pop             rdi
+                pop             rsi
+                pop             rdx
+                pop             rcx
+                pop             rbx
+                pop             rax
+                ret
+
+; subtracts 1 from a nonzero long number
+;    rdi -- address of long number
+;    rcx -- length of long number in qwords
+; result:
+;    rcx -- length of long number in qwords
+decrement_long:
+                push            rax
+
+                xor             rax, rax
+.loop:
+                sub             qword [rdi + 8 * rax], 1
+                jnc             .done
+                inc             rax
+                jmp             .loop
+
+.done:
+                call            normalize_long
+                pop             rax
+                ret
+
+
+                section         .bss
+; powers P_k and their lengths in qwords
+pow_addr:       resq            MAX_POWERS
+pow_len:        resq            MAX_POWERS
+; reciprocals I_k of P_k, their lengths in qwords and exponents e_k,
+; see make_inverses
+inv_addr:       resq            MAX_POWERS
+inv_len:        resq            MAX_POWERS
+inv_exp:        resq            MAX_POWERS
+; scratch space of mul_long_long for split_chunks
+split_scratch:  resq            1
@@ -0,0 +1,54 @@
+; prints differences of pairs of long numbers until the end of input
+                section         .text
+
+                extern          sub_long_long
+                extern          compare_long
+                extern          heap_mark
+                extern          heap_release
+                extern          read_long
+                extern          write_long
+                extern          write_line_end
+                extern          write_minus
+                extern          parse_args
+                extern          exit
+
+                global          _start
+_start:
+                mov             rdi, rsp
+                call            parse_args
+
+.next_pair:
+                call            heap_mark
+                push            rax
+
+                call            read_long
+                jc              .done
+                mov             r8, rdi
+                mov             r9, rcx
+                call            read_long
+                jc              .done
+                mov             rsi, rdi
+                mov             rdx, rcx
+                mov             rdi, r8
+                mov             rcx, r9
+
+; if minuend is less than subtrahend, subtrahend - minuend is written
+; with minus
+                call            compare_long
+                jae             .subtract
+                xchg            rdi, rsi
+                xchg            rcx, rdx
+                call            write_minus
+.subtract:
+                call            sub_long_long
+
+                call            write_long
+
+                call            write_line_end
+
+                pop             rax
+                call            heap_release
+                jmp             .next_pair
+
+.done:
+                jmp             exit
@@ -0,0 +1,231 @@
+"""Checks add, sub or mul on a seeded corpus of pairs of numbers.
+
+The corpus is generated once and split into shards, at least two and one
+per core; every shard is fed to one process of the program, which reads
+pairs until the end of input. Every other shard is written to a pipe and
+the rest is read from files, so that both the buffered and the mapped
+input are checked. Small numbers are passed in decimal, large ones in
+hexadecimal (option -x), whose conversion takes linear time; some pairs
+are passed with the 0x prefix without -x, mixed with decimal numbers, and
+in binary (option -b), where negative results of sub are read back too.
+
+usage: corpus.py program [--seed N] [--cases N] [--max-decimal-bits N]
+                         [--big-cases N] [--max-bits N] [--jobs N]
+"""
+import argparse
+import decimal
+import operator
+import os
+import random
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+# python 3.11+ limits conversion of long ints to decimal strings
+if hasattr(sys, 'set_int_max_str_digits'):
+    sys.set_int_max_str_digits(0)
+
+OPERATIONS = {'add': operator.add, 'sub': operator.sub, 'mul': operator.mul}
+
+
+def fixed_pairs():
+    """Cases of the former generate.py: edge cases and 64 sizes of 128 bits."""
+    pairs = [(1, 2**200), (0, 2**211), (4, int('1' * 200)), (int('1' * 200), 5)]
+    rng = random.Random(0)
+    for size in range(1, 65):
+        low, high = 2**(128 * (size - 1)) - 1, 2**(128 * size) - 1
+        pairs.append((rng.randint(low, high), rng.randint(low, high)))
+    return pairs
+
+
+def random_number(rng, max_bits):
+    """Number of log-uniform size, sometimes of a special form."""
+    bits = int(2 ** rng.uniform(0, max_bits.bit_length() - 1))
+    kind = rng.randrange(8)
+    if kind == 0:
+        return 0
+    if kind == 1:
+        return 2**bits - 1
+    if kind == 2:
+        return 2**bits
+    return rng.getrandbits(bits)
+
+
+def random_pairs(rng, cases, max_bits):
+    pairs = []
+    for _ in range(cases):
+        x = random_number(rng, max_bits)
+        kind = rng.randrange(6)
+        if kind == 0:
+            y = x
+        elif kind == 1:
+            y = x + rng.choice([-1, 1])
+        else:
+            y = random_number(rng, max_bits)
+        pairs.append((x, max(y, 0)))
+    return pairs
+
+
+# str() of a long int takes quadratic time, decimal module multiplies in
+# subquadratic time, so large numbers are converted by halves through it
+DECIMAL_CONTEXT = decimal.Context(prec=decimal.MAX_PREC, Emax=decimal.MAX_EMAX)
+DIRECT_DECIMAL_BITS = 4096
+powers_of_two = {}
+
+
+def to_decimal(number):
+    """Decimal equal to a non-negative int."""
+    bits = number.bit_length()
+    if bits <= DIRECT_DECIMAL_BITS:
+        return decimal.Decimal(number)
+    half = 1 << (bits.bit_length() - 2)
+    if half not in powers_of_two:
+        powers_of_two[half] = DECIMAL_CONTEXT.power(decimal.Decimal(2), half)
+    high = number >> half
+    low = number - (high << half)
+    return DECIMAL_CONTEXT.fma(to_decimal(high), powers_of_two[half], to_decimal(low))
+
+
+def to_text(number, hexadecimal):
+    sign = '-' if number < 0 else ''
+    if not hexadecimal:
+        return sign + str(to_decimal(abs(number)))
+    return sign + hex(abs(number))
+
+
+def limbs(number):
+    return (number.bit_length() + 63) // 64
+
+
+def to_binary(number):
+    """Length in qwords and qwords, the highest bit of length is the sign."""
+    length = limbs(abs(number)) | (1 << 63 if number < 0 else 0)
+    return length.to_bytes(8, 'little') + abs(number).to_bytes(8 * limbs(abs(number)), 'little')
+
+
+def from_binary(data):
+    numbers = []
+    position = 0
+    while position + 8 <= len(data):
+        length = int.from_bytes(data[position:position + 8], 'little')
+        position += 8
+        size = 8 * (length & ~(1 << 63))
+        number = int.from_bytes(data[position:position + size], 'little')
+        position += size
+        numbers.append(-number if length >> 63 else number)
+    return numbers
+
+
+# options of the program and which numbers of the pair with index i are
+# hexadecimal (x, y) for every form of input; output is in the form of y
+FORMS = {
+    'decimal': ([], lambda i: (False, False)),
+    'hexadecimal': (['-x'], lambda i: (True, True)),
+    'prefixed': ([], lambda i: (i % 2 == 0, i % 3 != 0)),
+    'binary': (['-b'], None),
+}
+
+
+def encode(form, i, x, y):
+    if form == 'binary':
+        return to_binary(x) + to_binary(y)
+    x_hexadecimal, y_hexadecimal = FORMS[form][1](i)
+    return (to_text(x, x_hexadecimal) + '\n' + to_text(y, y_hexadecimal) + '\n').encode()
+
+
+def expected_output(form, i, result):
+    if form == 'binary':
+        return result
+    return to_text(result, FORMS[form][1](i)[1])
+
+
+def run(program, pairs, form, jobs):
+    """Runs shards in parallel, returns outputs in order of pairs and time."""
+    shards = max(jobs, 2)
+    inputs = [b''.join(encode(form, i, x, y) for i, (x, y) in enumerate(pairs) if i % shards == shard)
+              for shard in range(shards)]
+    with tempfile.TemporaryDirectory() as directory:
+        for shard, data in enumerate(inputs):
+            with open(os.path.join(directory, 'input%d' % shard), 'wb') as file:
+                file.write(data)
+        # outputs go to files, so that no process waits for its pipe to be read
+        outputs = [open(os.path.join(directory, 'output%d' % shard), 'wb+') for shard in range(shards)]
+        start = time.perf_counter()
+        processes = []
+        writers = []
+        for shard in range(shards):
+            if shard % 2 == 1:
+                process = subprocess.Popen([program] + FORMS[form][0], stdin=subprocess.PIPE,
+                                           stdout=outputs[shard])
+                writers.append(threading.Thread(target=process.communicate, args=(inputs[shard],)))
+                writers[-1].start()
+            else:
+                with open(os.path.join(directory, 'input%d' % shard), 'rb') as input_file:
+                    process = subprocess.Popen([program] + FORMS[form][0], stdin=input_file,
+                                               stdout=outputs[shard])
+            processes.append(process)
+        for writer in writers:
+            writer.join()
+        for process in processes:
+            process.wait()
+        elapsed = time.perf_counter() - start
+        results = [None] * len(pairs)
+        for shard, output_file in enumerate(outputs):
+            output_file.seek(0)
+            data = output_file.read()
+            output_file.close()
+            output = from_binary(data) if form == 'binary' else data.decode().split('\n')
+            for j, result in enumerate(output[:len(range(shard, len(pairs), shards))]):
+                results[shard + j * shards] = result
+    return results, elapsed
+
+
+def check(program, operation, pairs, form, jobs):
+    results, elapsed = run(program, pairs, form, jobs)
+    for i, ((x, y), result) in enumerate(zip(pairs, results)):
+        expected = expected_output(form, i, operation(x, y))
+        if result != expected:
+            x_text, y_text = (to_text(x, True), to_text(y, True)) if form == 'binary' else \
+                encode(form, i, x, y).decode().split('\n')[:2]
+            print('Fail (%s) on x = %s, y = %s' % (form, x_text[:80], y_text[:80]))
+            print('Expected %s' % str(expected)[:80])
+            print('Found %s' % (str(result)[:80] if result is not None else 'nothing'))
+            return False
+    qwords = sum(limbs(x) + limbs(y) for x, y in pairs)
+    print('%s: %d pairs OK, %.0f ops/s, %.0f qwords/s' %
+          (form, len(pairs), len(pairs) / elapsed, qwords / elapsed))
+    return True
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('program')
+    parser.add_argument('--seed', type=int, default=1)
+    parser.add_argument('--cases', type=int, default=20000)
+    parser.add_argument('--max-decimal-bits', type=int, default=1 << 18)
+    parser.add_argument('--big-cases', type=int, default=200)
+    parser.add_argument('--max-bits', type=int, default=1 << 20)
+    parser.add_argument('--jobs', type=int, default=os.cpu_count() or 1)
+    args = parser.parse_args()
+
+    operation = OPERATIONS[os.path.basename(args.program)]
+    rng = random.Random(args.seed)
+    decimal = fixed_pairs() + random_pairs(rng, args.cases, args.max_decimal_bits)
+    big = random_pairs(rng, args.big_cases, args.max_bits)
+    prefixed = random_pairs(rng, args.cases // 4, args.max_decimal_bits)
+    binary = random_pairs(rng, args.cases // 4, args.max_decimal_bits) + big
+
+    start = time.perf_counter()
+    passed = (check(args.program, operation, decimal, 'decimal', args.jobs) and
+              check(args.program, operation, big, 'hexadecimal', args.jobs) and
+              check(args.program, operation, prefixed, 'prefixed', args.jobs) and
+              check(args.program, operation, binary, 'binary', args.jobs))
+    print('%s in %.1f s' % ('Tests passed' if passed else 'Tests failed',
+                            time.perf_counter() - start))
+    sys.exit(0 if passed else 1)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,392 @@
+/*
+ * checks routines of long_c.h against mpn_* of GMP on random numbers of
+ * random lengths, lengths 0 and 1 included; every routine is called through
+ * checked_call, which also checks that callee-saved registers and the
+ * direction flag are kept, and limbs around results are checked to be kept
+ *
+ * usage: long_c_test [seed] [rounds]
+ */
+
+#include <gmp.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../long_c.h"
+
+#define MAX_LENGTH 300
+/* squares reach both Karatsuba's method (from 48 limbs) and scratch space
+   taken with malloc (above 64 KiB, about 800 limbs) */
+#define MAX_SQR_LENGTH 1100
+#define GUARD 4
+#define GUARD_LIMB 0x5a5a5a5a5a5a5a5aULL
+
+/*
+ * uint64_t checked_call(void *fn, uint64_t a, uint64_t b, uint64_t c,
+ *                       uint64_t d)
+ * calls fn(a, b, c, d) with known values in rbx, rbp and r12 - r15 and the
+ * stack aligned as the ABI requires, clobbered is set if any of them or
+ * DF is changed
+ */
+__asm__(
+    "        .text\n"
+    "        .globl  checked_call\n"
+    "checked_call:\n"
+    "        push    %rbx\n"
+    "        push    %rbp\n"
+    "        push    %r12\n"
+    "        push    %r13\n"
+    "        push    %r14\n"
+    "        push    %r15\n"
+    "        sub     $8, %rsp\n"
+    "        mov     %rdi, %rax\n"
+    "        mov     %rsi, %rdi\n"
+    "        mov     %rdx, %rsi\n"
+    "        mov     %rcx, %rdx\n"
+    "        mov     %r8, %rcx\n"
+    "        movabs  $0x1111111111111111, %rbx\n"
+    "        movabs  $0x2222222222222222, %rbp\n"
+    "        movabs  $0x3333333333333333, %r12\n"
+    "        movabs  $0x4444444444444444, %r13\n"
+    "        movabs  $0x5555555555555555, %r14\n"
+    "        movabs  $0x6666666666666666, %r15\n"
+    "        call    *%rax\n"
+    "        xor     %ecx, %ecx\n"
+    "        movabs  $0x1111111111111111, %rdx\n"
+    "        cmp     %rdx, %rbx\n"
+    "        setne   %cl\n"
+    "        movabs  $0x2222222222222222, %rdx\n"
+    "        cmp     %rdx, %rbp\n"
+    "        setne   %dl\n"
+    "        or      %dl, %cl\n"
+    "        movabs  $0x3333333333333333, %rdx\n"
+    "        cmp     %rdx, %r12\n"
+    "        setne   %dl\n"
+    "        or      %dl, %cl\n"
+    "        movabs  $0x4444444444444444, %rdx\n"
+    "        cmp     %rdx, %r13\n"
+    "        setne   %dl\n"
+    "        or      %dl, %cl\n"
+    "        movabs  $0x5555555555555555, %rdx\n"
+    "        cmp     %rdx, %r14\n"
+    "        setne   %dl\n"
+    "        or      %dl, %cl\n"
+    "        movabs  $0x6666666666666666, %rdx\n"
+    "        cmp     %rdx, %r15\n"
+    "        setne   %dl\n"
+    "        or      %dl, %cl\n"
+    "        pushf\n"
+    "        pop     %rdx\n"
+    "        shr     $10, %edx\n"
+    "        and     $1, %edx\n"
+    "        or      %dl, %cl\n"
+    "        or      %cl, clobbered(%rip)\n"
+    "        cld\n"
+    "        add     $8, %rsp\n"
+    "        pop     %r15\n"
+    "        pop     %r14\n"
+    "        pop     %r13\n"
+    "        pop     %r12\n"
+    "        pop     %rbp\n"
+    "        pop     %rbx\n"
+    "        ret\n");
+
+uint64_t checked_call(void *fn, uint64_t a, uint64_t b, uint64_t c, uint64_t d);
+
+unsigned char clobbered;
+
+static uint64_t state;
+
+/* xorshift64* */
+static uint64_t random_limb(void)
+{
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 0x2545f4914f6cdd1dULL;
+}
+
+static size_t random_length(void)
+{
+    switch (random_limb() % 4) {
+    case 0:
+        return random_limb() % 3;
+    case 1:
+        return random_limb() % 17;
+    default:
+        return random_limb() % (MAX_LENGTH + 1);
+    }
+}
+
+/* random limbs, sometimes all ones or zeros, so that carries run far */
+static void random_number(uint64_t *p, size_t n)
+{
+    size_t i;
+    uint64_t kind = random_limb() % 6;
+    for (i = 0; i < n; i++) {
+        if (kind == 0)
+            p[i] = 0;
+        else if (kind == 1)
+            p[i] = ~0ULL;
+        else if (kind == 2)
+            p[i] = random_limb() % 8 == 0 ? random_limb() : ~0ULL;
+        else
+            p[i] = random_limb();
+    }
+}
+
+static uint64_t random_short(void)
+{
+    switch (random_limb() % 5) {
+    case 0:
+        return 1;
+    case 1:
+        return ~0ULL;
+    case 2:
+        return random_limb() >> (random_limb() % 64);
+    default:
+        return random_limb();
+    }
+}
+
+/* buffer of n limbs with GUARD limbs on both sides */
+struct buffer {
+    uint64_t limbs[MAX_SQR_LENGTH * 2 + 2 * GUARD];
+};
+
+static uint64_t *fill_guards(struct buffer *b, size_t n)
+{
+    size_t i;
+    for (i = 0; i < GUARD; i++) {
+        b->limbs[i] = GUARD_LIMB;
+        b->limbs[GUARD + n + i] = GUARD_LIMB;
+    }
+    return b->limbs + GUARD;
+}
+
+static int guards_kept(struct buffer const *b, size_t n)
+{
+    size_t i;
+    for (i = 0; i < GUARD; i++)
+        if (b->limbs[i] != GUARD_LIMB || b->limbs[GUARD + n + i] != GUARD_LIMB)
+            return 0;
+    return 1;
+}
+
+static unsigned long round_number;
+
+static int report(char const *name, size_t n, char const *what)
+{
+    fprintf(stderr, "Fail in %s on n = %zu (round %lu): %s\n", name, n, round_number, what);
+    return 0;
+}
+
+/* compares result and return value of a routine with those of GMP */
+static int compare(char const *name, size_t n, struct buffer const *b, size_t length,
+                   uint64_t const *expected, uint64_t result, uint64_t expected_result)
+{
+    if (clobbered)
+        return report(name, n, "callee-saved register or DF changed");
+    if (!guards_kept(b, length))
+        return report(name, n, "limbs out of the result changed");
+    if (length != 0 && memcmp(b->limbs + GUARD, expected, length * sizeof(uint64_t)) != 0)
+        return report(name, n, "wrong result");
+    if (result != expected_result)
+        return report(name, n, "wrong return value");
+    return 1;
+}
+
+static int check_add_sub(void)
+{
+    static struct buffer r;
+    uint64_t u[MAX_LENGTH], v[MAX_LENGTH], expected[MAX_LENGTH], *rp;
+    size_t n = random_length();
+    int sub, alias;
+    random_number(u, n);
+    random_number(v, n);
+    for (sub = 0; sub < 2; sub++) {
+        void *fn = sub ? (void *)long_sub_n : (void *)long_add_n;
+        char const *name = sub ? "long_sub_n" : "long_add_n";
+        uint64_t expected_result = 0, result;
+        if (n != 0)
+            expected_result = sub ? mpn_sub_n(expected, u, v, n) : mpn_add_n(expected, u, v, n);
+        /* rp is a separate buffer, then equal to up, then to vp */
+        for (alias = 0; alias < 3; alias++) {
+            rp = fill_guards(&r, n);
+            if (alias == 0) {
+                result = checked_call(fn, (uint64_t)rp, (uint64_t)u, (uint64_t)v, n);
+            } else {
+                memcpy(rp, alias == 1 ? u : v, n * sizeof(uint64_t));
+                result = checked_call(fn, (uint64_t)rp, (uint64_t)(alias == 1 ? rp : u),
+                                      (uint64_t)(alias == 1 ? v : rp), n);
+            }
+            if (!compare(name, n, &r, n, expected, result, expected_result))
+                return 0;
+        }
+    }
+    return 1;
+}
+
+static int check_mul_1(void)
+{
+    static struct buffer r;
+    uint64_t u[MAX_LENGTH], w[MAX_LENGTH], expected[MAX_LENGTH], *rp, result;
+    uint64_t expected_result = 0, v = random_short();
+    size_t n = random_length();
+    int kind;
+    random_number(u, n);
+    random_number(w, n);
+
+    /* rp = up * v in a separate buffer and in place */
+    if (n != 0)
+        expected_result = mpn_mul_1(expected, u, n, v);
+    rp = fill_guards(&r, n);
+    result = checked_call((void *)long_mul_1, (uint64_t)rp, (uint64_t)u, n, v);
+    if (!compare("long_mul_1", n, &r, n, expected, result, expected_result))
+        return 0;
+    rp = fill_guards(&r, n);
+    memcpy(rp, u, n * sizeof(uint64_t));
+    result = checked_call((void *)long_mul_1, (uint64_t)rp, (uint64_t)rp, n, v);
+    if (!compare("long_mul_1", n, &r, n, expected, result, expected_result))
+        return 0;
+
+    /* rp += up * v and rp -= up * v */
+    for (kind = 0; kind < 2; kind++) {
+        void *fn = kind ? (void *)long_submul_1 : (void *)long_addmul_1;
+        char const *name = kind ? "long_submul_1" : "long_addmul_1";
+        memcpy(expected, w, n * sizeof(uint64_t));
+        expected_result = 0;
+        if (n != 0)
+            expected_result = kind ? mpn_submul_1(expected, u, n, v) : mpn_addmul_1(expected, u, n, v);
+        rp = fill_guards(&r, n);
+        memcpy(rp, w, n * sizeof(uint64_t));
+        result = checked_call(fn, (uint64_t)rp, (uint64_t)u, n, v);
+        if (!compare(name, n, &r, n, expected, result, expected_result))
+            return 0;
+    }
+    return 1;
+}
+
+static int check_divrem_1(void)
+{
+    static struct buffer r;
+    uint64_t u[MAX_LENGTH], expected[MAX_LENGTH], *qp, result, expected_result = 0;
+    uint64_t d = random_short();
+    size_t n = random_length();
+    while (d == 0)
+        d = random_short();
+    random_number(u, n);
+    if (n != 0)
+        expected_result = mpn_divrem_1(expected, 0, u, n, d);
+
+    /* qp is a separate buffer, then equal to up */
+    qp = fill_guards(&r, n);
+    result = checked_call((void *)long_divrem_1, (uint64_t)qp, (uint64_t)u, n, d);
+    if (!compare("long_divrem_1", n, &r, n, expected, result, expected_result))
+        return 0;
+    qp = fill_guards(&r, n);
+    memcpy(qp, u, n * sizeof(uint64_t));
+    result = checked_call((void *)long_divrem_1, (uint64_t)qp, (uint64_t)qp, n, d);
+    return compare("long_divrem_1", n, &r, n, expected, result, expected_result);
+}
+
+static int check_shift(void)
+{
+    static struct buffer r;
+    uint64_t u[MAX_LENGTH], expected[MAX_LENGTH], *rp, result, expected_result;
+    unsigned cnt = 1 + random_limb() % 63;
+    size_t n = 1 + random_limb() % MAX_LENGTH, offset;
+    int right;
+    random_number(u, n);
+    for (right = 0; right < 2; right++) {
+        void *fn = right ? (void *)long_rshift : (void *)long_lshift;
+        char const *name = right ? "long_rshift" : "long_lshift";
+        expected_result = right ? mpn_rshift(expected, u, n, cnt) : mpn_lshift(expected, u, n, cnt);
+
+        /* separate buffer, then up moved by 0 .. 2 limbs in the allowed
+           direction within rp */
+        rp = fill_guards(&r, n);
+        result = checked_call(fn, (uint64_t)rp, (uint64_t)u, n, cnt);
+        if (!compare(name, n, &r, n, expected, result, expected_result))
+            return 0;
+        for (offset = 0; offset < 3; offset++) {
+            uint64_t *up;
+            rp = fill_guards(&r, n);
+            up = right ? rp + offset : rp - offset;
+            memmove(up, u, n * sizeof(uint64_t));
+            result = checked_call(fn, (uint64_t)rp, (uint64_t)up, n, cnt);
+            if (offset != 0) {
+                /* limbs of up outside of rp are not part of the result */
+                uint64_t *outside = right ? rp + n : rp - offset;
+                size_t i;
+                for (i = 0; i < offset; i++)
+                    outside[i] = GUARD_LIMB;
+            }
+            if (!compare(name, n, &r, n, expected, result, expected_result))
+                return 0;
+        }
+    }
+    return 1;
+}
+
+/* odd lengths around the threshold of Karatsuba's method are more likely */
+static size_t random_sqr_length(void)
+{
+    switch (random_limb() % 4) {
+    case 0:
+        return 1 + random_limb() % 4;
+    case 1:
+        return (40 + random_limb() % 80) | 1;
+    case 2:
+        return (random_limb() % MAX_SQR_LENGTH) | 1;
+    default:
+        return 1 + random_limb() % MAX_SQR_LENGTH;
+    }
+}
+
+static int check_sqr(void)
+{
+    static struct buffer r;
+    uint64_t u[MAX_SQR_LENGTH], expected[2 * MAX_SQR_LENGTH], *rp;
+    size_t n = random_sqr_length(), offset;
+    random_number(u, n);
+    mpn_sqr(expected, u, n);
+
+    rp = fill_guards(&r, 2 * n);
+    checked_call((void *)long_sqr, (uint64_t)rp, (uint64_t)u, n, 0);
+    if (!compare("long_sqr", n, &r, 2 * n, expected, 0, 0))
+        return 0;
+
+    /* up at the start, at the end and at a random place of rp */
+    for (offset = 0; offset < 3; offset++) {
+        uint64_t *up;
+        rp = fill_guards(&r, 2 * n);
+        up = rp + (offset == 0 ? 0 : offset == 1 ? n : random_limb() % (n + 1));
+        memcpy(up, u, n * sizeof(uint64_t));
+        checked_call((void *)long_sqr, (uint64_t)rp, (uint64_t)up, n, 0);
+        if (!compare("long_sqr", n, &r, 2 * n, expected, 0, 0))
+            return 0;
+    }
+    return 1;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned long rounds = 2000;
+    state = argc > 1 ? strtoull(argv[1], NULL, 0) : 1;
+    if (argc > 2)
+        rounds = strtoul(argv[2], NULL, 0);
+    /* xorshift state must not be zero */
+    state = state * 2 + 1;
+
+    for (round_number = 0; round_number < rounds; round_number++) {
+        if (!check_add_sub() || !check_mul_1() || !check_divrem_1() || !check_shift() ||
+            !check_sqr()) {
+            printf("Tests failed\n");
+            return 1;
+        }
+    }
+    printf("long_c: %lu rounds OK\nTests passed\n", rounds);
+    return 0;
+}
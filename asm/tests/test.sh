@@ -1,29 +1,49 @@
 #!/bin/bash
 echo Testing $EXEC
 
-if [[ $EXEC == "mul" ]]; then
-    sort=0
-else
-    sort=1
-fi
+# check name expected found
+check() {
+    if [ "$3" != "$2" ]; then
+        echo "Fail $1"
+        echo "Expected $2"
+        echo "Found $3"
+        exit 1
+    fi
+}
 
-time=$(date +%s%N | cut -b1-13)
-for number in {1..68}
-do
-    python3 generate.py $number $sort > input.txt
-    result=$(cat input.txt | ../build/$EXEC)
-    for line in $(cat output.txt) 
-    do
-        if [[ "$line" == "$result" ]]; then
-            echo "Test $number: OK"
-            rm output.txt input.txt
-        else
-            echo "Test $number: Fail!"
-            echo "Expected $line."
-            echo "Found $result"
-            echo "You failed on test $number"
-            exit 1
-        fi
-    done
-done
-echo "Tests passed in $(($(date +%s%N | cut -b1-13) - $time)) miliseconds"
+# writes qwords given in decimal or with 0x prefix in binary, little-endian;
+# the program may stop reading before the end, so the broken pipe is quiet
+binary() {
+    python3 -c 'import struct, sys
+sys.stdout.buffer.write(struct.pack("<%dQ" % (len(sys.argv) - 1), *(int(q, 0) for q in sys.argv[1:])))' "$@" 2>/dev/null
+}
+
+hex_bytes() {
+    od -An -tx1 | tr -d ' \n'
+}
+
+# the heap must not grow beyond what a small pair needs, so that the
+# program works under a tight limit of address space (in KiB)
+LIMIT=16384
+case $EXEC in
+    add) expected=5 ; round_trip="1 6" ;;
+    sub) expected=1 ; round_trip="0" ;;
+    mul) expected=6 ; round_trip="1 6" ;;
+esac
+found=$(ulimit -v $LIMIT; printf '3\n2\n' | ../build/$EXEC)
+check "under ulimit -v $LIMIT on x = 3, y = 2" "$expected" "$found"
+
+# output of -b is read back: (x op y) op 1 for x = 3, y = 2
+found=$( (../build/$EXEC -b < <(binary 1 3 1 2); binary 1 1) | ../build/$EXEC -b | hex_bytes)
+check "on -b round trip of x = 3, y = 2" "$(binary $round_trip | hex_bytes)" "$found"
+
+# negative result of sub -b has the highest bit of length set, it is not
+# a valid input, neither is a length that overflows the size in bytes
+found=$( (../build/sub -b < <(binary 1 2 1 3); binary 1 1) | ../build/$EXEC -b)
+check "on -b round trip of 2 - 3" "Invalid length of binary number" "$found"
+found=$(binary 0x2000000000000000 1 1 1 | ../build/$EXEC -b)
+check "on -b length 2^61" "Invalid length of binary number" "$found"
+
+# all cases are run by corpus.py in a few processes of the program,
+# options of corpus.py (e.g. --seed, --cases) are passed through
+python3 corpus.py ../build/$EXEC "$@"
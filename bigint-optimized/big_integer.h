@@ -2,18 +2,33 @@
 #define BIG_INTEGER_H
 
 #include <cstddef>
-#include <gmp.h>
+#include <cstdint>
 #include <iosfwd>
+#include <string>
+
+#include "limb_storage.h"
 
 struct big_integer
 {
+    // magnitude is kept in limbs, least significant limb first, without
+    // leading zero limbs, so zero has no limbs; storage_t only needs size,
+    // resize, operator[], data, back, push_back and pop_back
+    using limb_t = uint32_t;
+    using storage_t = limb_storage;
+
     big_integer();
     big_integer(big_integer const& other);
+    // other is left zero
+    big_integer(big_integer&& other) noexcept;
     big_integer(int a);
     explicit big_integer(std::string const& str);
     ~big_integer();
 
     big_integer& operator=(big_integer const& other);
+    // other is left with the old value of *this
+    big_integer& operator=(big_integer&& other) noexcept;
+
+    void swap(big_integer& other) noexcept;
 
     big_integer& operator+=(big_integer const& rhs);
     big_integer& operator-=(big_integer const& rhs);
@@ -47,19 +62,45 @@ struct big_integer
 
     friend std::string to_string(big_integer const& a);
 
+    // a * b + c, a * b - c, c - a * b and (a << k) + b computed straight
+    // into the result, without temporaries; big_integer_expr.h maps lazy
+    // expressions onto them
+    friend big_integer mul_add(big_integer const& a, big_integer const& b, big_integer const& c);
+    friend big_integer mul_sub(big_integer const& a, big_integer const& b, big_integer const& c);
+    friend big_integer sub_mul(big_integer const& c, big_integer const& a, big_integer const& b);
+    friend big_integer shl_add(big_integer const& a, int k, big_integer const& b);
+
 private:
-    mpz_t mpz;
+    big_integer& bitwise(big_integer const& rhs, limb_t (*op)(limb_t, limb_t));
+    void normalize();
+
+    // c with sign c_negative plus a * b with sign product_negative
+    static big_integer fused_mul(big_integer const& c, bool c_negative,
+                                 big_integer const& a, big_integer const& b, bool product_negative);
+
+    bool negative;
+    storage_t limbs;
 };
 
+void swap(big_integer& a, big_integer& b) noexcept;
+
+// the left operand is taken by value, so a temporary one is moved in and
+// its limbs are reused for the result; commutative operators reuse a
+// temporary right operand as well
 big_integer operator+(big_integer a, big_integer const& b);
+big_integer operator+(big_integer const& a, big_integer&& b);
 big_integer operator-(big_integer a, big_integer const& b);
 big_integer operator*(big_integer a, big_integer const& b);
+big_integer operator*(big_integer const& a, big_integer&& b);
 big_integer operator/(big_integer a, big_integer const& b);
 big_integer operator%(big_integer a, big_integer const& b);
 
 big_integer operator&(big_integer a, big_integer const& b);
+big_integer operator&(big_integer const& a, big_integer&& b);
 big_integer operator|(big_integer a, big_integer const& b);
+big_integer operator|(big_integer const& a, big_integer&& b);
 big_integer operator^(big_integer a, big_integer const& b);
+big_integer operator^(big_integer const& a, big_integer&& b);
 
 big_integer operator<<(big_integer a, int b);
 big_integer operator>>(big_integer a, int b);
@@ -71,6 +112,11 @@ bool operator>(big_integer const& a, big_integer const& b);
 bool operator<=(big_integer const& a, big_integer const& b);
 bool operator>=(big_integer const& a, big_integer const& b);
 
+big_integer mul_add(big_integer const& a, big_integer const& b, big_integer const& c);
+big_integer mul_sub(big_integer const& a, big_integer const& b, big_integer const& c);
+big_integer sub_mul(big_integer const& c, big_integer const& a, big_integer const& b);
+big_integer shl_add(big_integer const& a, int k, big_integer const& b);
+
 std::string to_string(big_integer const& a);
 std::ostream& operator<<(std::ostream& s, big_integer const& a);
 
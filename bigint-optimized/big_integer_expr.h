@@ -0,0 +1,104 @@
+#ifndef BIG_INTEGER_EXPR_H
+#define BIG_INTEGER_EXPR_H
+
+#include "big_integer.h"
+
+// opt-in lazy expressions: lazy(a) * b and lazy(a) << k are nodes instead
+// of values, so a following + or - sees the whole expression and computes
+// a * b + c, a * b - c, c - a * b and (a << k) + b by one fused pass into
+// the result, without temporaries:
+//
+//     big_integer residue = dividend - lazy(quotient) * divisor;
+//
+// a node used in any other way is converted to big_integer; nodes refer to
+// their operands, so they must not outlive the full expression
+
+struct lazy_operand
+{
+    big_integer const& value;
+};
+
+struct product_expr
+{
+    big_integer const& a;
+    big_integer const& b;
+
+    operator big_integer() const;
+};
+
+struct shift_expr
+{
+    big_integer const& a;
+    int k;
+
+    operator big_integer() const;
+};
+
+inline lazy_operand lazy(big_integer const& a)
+{
+    return lazy_operand{a};
+}
+
+inline product_expr operator*(lazy_operand a, big_integer const& b)
+{
+    return product_expr{a.value, b};
+}
+
+inline shift_expr operator<<(lazy_operand a, int k)
+{
+    return shift_expr{a.value, k};
+}
+
+inline product_expr::operator big_integer() const
+{
+    return a * b;
+}
+
+inline shift_expr::operator big_integer() const
+{
+    return a << k;
+}
+
+inline big_integer operator+(product_expr p, big_integer const& c)
+{
+    return mul_add(p.a, p.b, c);
+}
+
+// a temporary right operand of + would make the rvalue operator+ of
+// big_integer an equally good match without these
+inline big_integer operator+(product_expr p, big_integer&& c)
+{
+    return mul_add(p.a, p.b, c);
+}
+
+inline big_integer operator+(big_integer const& c, product_expr p)
+{
+    return mul_add(p.a, p.b, c);
+}
+
+inline big_integer operator-(product_expr p, big_integer const& c)
+{
+    return mul_sub(p.a, p.b, c);
+}
+
+inline big_integer operator-(big_integer const& c, product_expr p)
+{
+    return sub_mul(c, p.a, p.b);
+}
+
+inline big_integer operator+(shift_expr s, big_integer const& b)
+{
+    return shl_add(s.a, s.k, b);
+}
+
+inline big_integer operator+(shift_expr s, big_integer&& b)
+{
+    return shl_add(s.a, s.k, b);
+}
+
+inline big_integer operator+(big_integer const& b, shift_expr s)
+{
+    return shl_add(s.a, s.k, b);
+}
+
+#endif // BIG_INTEGER_EXPR_H
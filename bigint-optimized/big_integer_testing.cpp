@@ -2,11 +2,13 @@
 #include <cassert>
 #include <cstdlib>
 #include <random>
+#include <string>
 #include <vector>
 #include <utility>
 #include <gtest/gtest.h>
 
 #include "big_integer.h"
+#include "big_integer_expr.h"
 #include "big_integer_gmp.h"
 
 TEST(correctness, two_plus_two) {
@@ -52,6 +54,148 @@ TEST(correctness, copy_ctor_real_copy2) {
   EXPECT_EQ(3, a);
 }
 
+namespace {
+// longer than the inline limbs, so copies share a heap buffer
+char const long_value[] = "123456789012345678901234567890123456789012345678901234567890";
+
+void (*const in_place_mutations[])(big_integer&) = {
+  [](big_integer& x) { x += big_integer("98765432109876543210987654321098765432109876543210"); },
+  [](big_integer& x) { x -= big_integer("98765432109876543210987654321098765432109876543210"); },
+  [](big_integer& x) { x *= big_integer("98765432109876543210987654321098765432109876543210"); },
+  [](big_integer& x) { x <<= 37; },
+  [](big_integer& x) { x >>= 37; },
+  [](big_integer& x) { x &= big_integer("98765432109876543210987654321098765432109876543210"); },
+  [](big_integer& x) { x = -x; },
+  [](big_integer& x) { x /= 7; },
+};
+}
+
+TEST(correctness, copy_on_write_copy_changed) {
+  for (auto mutate : in_place_mutations) {
+    big_integer expected(long_value);
+    mutate(expected);
+
+    big_integer a(long_value);
+    big_integer b = a;
+    mutate(b);
+
+    EXPECT_EQ(long_value, to_string(a));
+    EXPECT_EQ(expected, b);
+  }
+}
+
+TEST(correctness, copy_on_write_source_changed) {
+  for (auto mutate : in_place_mutations) {
+    big_integer expected(long_value);
+    mutate(expected);
+
+    big_integer a(long_value);
+    big_integer b = a;
+    mutate(a);
+
+    EXPECT_EQ(long_value, to_string(b));
+    EXPECT_EQ(expected, a);
+  }
+}
+
+TEST(correctness, copy_on_write_shared_operand) {
+  big_integer b(long_value);
+  big_integer a;
+  a = b;
+  a += b;
+
+  EXPECT_EQ(long_value, to_string(b));
+  EXPECT_EQ(big_integer(long_value) * 2, a);
+
+  a = b;
+  a -= b;
+
+  EXPECT_EQ(long_value, to_string(b));
+  EXPECT_EQ(0, a);
+
+  a = b;
+  a *= b;
+
+  EXPECT_EQ(long_value, to_string(b));
+  EXPECT_EQ(big_integer(long_value) * big_integer(long_value), a);
+}
+
+namespace {
+// 2^96 and 2^128 - 1 fill the four inline limbs, 2^128 takes a fifth one
+std::string const pow2_96 = "79228162514264337593543950336";
+std::string const pow2_128_minus_1 = "340282366920938463463374607431768211455";
+std::string const pow2_128 = "340282366920938463463374607431768211456";
+
+std::string const signs[] = {"", "-"};
+}
+
+TEST(correctness, inline_to_heap_growth) {
+  for (std::string const& sign : signs) {
+    big_integer a(sign + pow2_128_minus_1);
+    big_integer b = a;
+    b += big_integer(sign + "1");
+
+    EXPECT_EQ(big_integer(sign + pow2_128), b);
+    EXPECT_EQ(sign + pow2_128_minus_1, to_string(a));
+
+    big_integer c(sign + pow2_96);
+    big_integer d = c;
+    d <<= 32;
+
+    EXPECT_EQ(big_integer(sign + pow2_128), d);
+    EXPECT_EQ(sign + pow2_96, to_string(c));
+  }
+}
+
+TEST(correctness, heap_shrunk_to_inline) {
+  for (std::string const& sign : signs) {
+    big_integer a(sign + pow2_128);
+    a -= big_integer(sign + "1");
+
+    big_integer b = a;
+    EXPECT_EQ(big_integer(sign + pow2_128_minus_1), b);
+    b += big_integer(sign + "1");
+    EXPECT_EQ(big_integer(sign + pow2_128), b);
+    EXPECT_EQ(sign + pow2_128_minus_1, to_string(a));
+
+    big_integer c(sign + pow2_128);
+    c >>= 32;
+
+    big_integer d = 5;
+    d = c;
+    EXPECT_EQ(big_integer(sign + pow2_96), d);
+    d <<= 32;
+    EXPECT_EQ(big_integer(sign + pow2_128), d);
+    EXPECT_EQ(sign + pow2_96, to_string(c));
+
+    big_integer e(long_value);
+    e = c;
+    EXPECT_EQ(big_integer(sign + pow2_96), e);
+    e -= big_integer(sign + "1");
+    EXPECT_EQ(sign + pow2_96, to_string(c));
+  }
+}
+
+TEST(correctness, assignment_across_inline_and_heap) {
+  for (std::string const& sign : signs) {
+    big_integer large(sign + pow2_128);
+    big_integer small = 7;
+    small = large;
+    EXPECT_EQ(big_integer(sign + pow2_128), small);
+    small -= big_integer(sign + "1");
+    EXPECT_EQ(big_integer(sign + pow2_128_minus_1), small);
+    EXPECT_EQ(sign + pow2_128, to_string(large));
+
+    big_integer source(sign + pow2_128_minus_1);
+    big_integer target(long_value);
+    target = source;
+    EXPECT_EQ(big_integer(sign + pow2_128_minus_1), target);
+    target += big_integer(sign + "1");
+    EXPECT_EQ(big_integer(sign + pow2_128), target);
+    EXPECT_EQ(sign + pow2_128_minus_1, to_string(source));
+  }
+}
+
 TEST(correctness, assignment_operator) {
   big_integer a = 4;
   big_integer b = 7;
@@ -76,6 +220,38 @@ TEST(correctness, assignment_return_value) {
   EXPECT_TRUE(b == 7);
 }
 
+TEST(correctness, move_ctor) {
+  big_integer a("-123456789012345678901234567890");
+  big_integer b = std::move(a);
+
+  EXPECT_EQ(big_integer("-123456789012345678901234567890"), b);
+  EXPECT_EQ(0, a);
+}
+
+TEST(correctness, move_assignment) {
+  big_integer a("123456789012345678901234567890");
+  big_integer b = 7;
+  b = std::move(a);
+
+  EXPECT_EQ(big_integer("123456789012345678901234567890"), b);
+  a = 5;
+  EXPECT_EQ(5, a);
+}
+
+TEST(correctness, rvalue_operands) {
+  big_integer a("123456789012345678901234567890");
+  big_integer b("-98765432109876543210");
+
+  EXPECT_EQ(a * b + a, big_integer(a) * b + a);
+  EXPECT_EQ(a + a * b, a + big_integer(a) * b);
+  EXPECT_EQ(a * 2, a + big_integer(a));
+  EXPECT_EQ(a * a, a * big_integer(a));
+  EXPECT_EQ(b & a, big_integer(b) & a);
+  EXPECT_EQ(b | a, a | big_integer(b));
+  EXPECT_EQ(0, (a ^ big_integer(a)));
+  EXPECT_EQ(a - b, (a - 0) - (b - 0));
+}
+
 TEST(correctness, comparisons) {
   big_integer a = 100;
   big_integer b = 100;
@@ -670,6 +846,15 @@ TEST(correctness, div_randomized) {
   }
 }
 
+TEST(correctness, lazy_div_randomized) {
+  for (size_t itn = 0; itn != number_of_iterations * number_of_multipliers; ++itn) {
+    big_integer divident = rand_big(10);
+    big_integer divisor = rand_big(6);
+    big_integer quotient = divident / divisor;
+    ASSERT_EQ(divident - lazy(quotient) * divisor, divident % divisor);
+  }
+}
+
 // y2019 tests
 
 TEST(correctness_random, cmp) {
@@ -789,6 +974,41 @@ TEST(correctness_random, bit_shifts) {
   }
 }
 
+TEST(correctness_random, lazy_fused) {
+  std::default_random_engine rng(42);
+  for (size_t itn = 0; itn != number_of_iterations; ++itn) {
+    big_integer_gmp a, b, c;
+    a.random(myrand() % max_size, rng);
+    b.random(myrand() % max_size, rng);
+    c.random(myrand() % (2 * max_size), rng);
+    int shift = myrand() % max_size;
+    big_integer A = big_integer(to_string(a));
+    big_integer B = big_integer(to_string(b));
+    big_integer C = big_integer(to_string(c));
+
+    EXPECT_EQ(to_string(a * b + c), to_string(lazy(A) * B + C));
+    EXPECT_EQ(to_string(c + a * b), to_string(C + lazy(A) * B));
+    EXPECT_EQ(to_string(a * b - c), to_string(lazy(A) * B - C));
+    EXPECT_EQ(to_string(c - a * b), to_string(C - lazy(A) * B));
+    EXPECT_EQ(to_string((a << shift) + c), to_string((lazy(A) << shift) + C));
+    EXPECT_EQ(to_string(c + (a << shift)), to_string(C + (lazy(A) << shift)));
+    EXPECT_EQ(to_string(a * b), to_string(big_integer(lazy(A) * B)));
+  }
+}
+
+TEST(correctness, lazy_fused_signs) {
+  big_integer a("-18446744073709551616"); // -(1 << 64)
+  big_integer b = 3;
+
+  EXPECT_EQ(0, lazy(a) * b - a * b);
+  EXPECT_EQ(0, a * b - lazy(a) * b);
+  EXPECT_EQ(1, lazy(a) * b + (-a * b + 1));
+  EXPECT_EQ(-1, lazy(a) * 0 - 1);
+  EXPECT_EQ(a * 4, (lazy(a) << 2) + 0);
+  EXPECT_EQ(0, (lazy(a) << 1) + (-a * 2));
+  EXPECT_EQ(-a, (lazy(a) << 1) + (-a * 3));
+}
+
 // TODO: extend due to idea
 TEST(correctness_twos_complement, simple) {
   std::string a = "-36893488147419103232"; // -(1 << 65)
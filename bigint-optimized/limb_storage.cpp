@@ -0,0 +1,15 @@
+#include "limb_storage.h"
+
+#include <new>
+
+void limb_storage::new_buffer(size_t new_capacity)
+{
+    void* memory = operator new(sizeof(shared_buffer) + new_capacity * sizeof(uint32_t));
+    shared_buffer* heap = new (memory) shared_buffer();
+    heap->refs.store(1, std::memory_order_relaxed);
+    limb_storage const& self = *this;
+    std::copy(self.data(), self.data() + size_, heap->limbs());
+    release();
+    buffer_.heap = heap;
+    capacity_ = new_capacity;
+}
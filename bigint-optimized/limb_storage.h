@@ -0,0 +1,233 @@
+#ifndef LIMB_STORAGE_H
+#define LIMB_STORAGE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// array of limbs with the part of std::vector interface big_integer uses;
+// up to INLINE_LIMBS limbs are kept in the object itself, so small numbers
+// never allocate, longer arrays are kept in a heap buffer; copies share the
+// heap buffer and count references to it, the buffer is cloned when a copy
+// that shares it is about to be changed (copy on write); the count is
+// atomic, so copies of one object may be made and dropped in different
+// threads
+struct limb_storage
+{
+    using value_type = uint32_t;
+
+    limb_storage();                                     // O(1) nothrow
+    limb_storage(limb_storage const& other);            // O(1) nothrow
+    limb_storage& operator=(limb_storage const& other); // O(1) nothrow
+
+    // other is left empty by the constructor and gets the old limbs of
+    // *this by the assignment
+    limb_storage(limb_storage&& other) noexcept;        // O(1) nothrow
+    limb_storage& operator=(limb_storage&& other) noexcept; // O(1) nothrow
+
+    ~limb_storage();                                    // O(1) nothrow
+
+    // the non-const versions clone a shared buffer
+    uint32_t& operator[](size_t i);                     // O(1)* strong
+    uint32_t const& operator[](size_t i) const;         // O(1) nothrow
+
+    size_t size() const;                                // O(1) nothrow
+
+    uint32_t& back();                                   // O(1)* strong
+    uint32_t const& back() const;                       // O(1) nothrow
+    void push_back(uint32_t a);                         // O(1)* strong
+    void pop_back();                                    // O(1) nothrow
+
+    // new limbs are zero
+    void resize(size_t new_size);                       // O(N) strong
+
+    // limbs in a row; the non-const version clones a shared buffer, so
+    // loops take the pointer once instead of indexing
+    uint32_t* data();                                   // O(1)* strong
+    uint32_t const* data() const;                       // O(1) nothrow
+
+    void swap(limb_storage& other) noexcept;            // O(1) nothrow
+
+private:
+    // heap buffer, capacity_ limbs follow the header
+    struct shared_buffer
+    {
+        std::atomic<size_t> refs;
+
+        uint32_t* limbs();
+    };
+
+    static size_t const INLINE_LIMBS = 4;
+
+    bool is_inline() const;
+    void unshare();
+    // moves limbs to a new heap buffer of new_capacity > INLINE_LIMBS limbs,
+    // the old buffer is released; defined out of line to keep the inline
+    // paths small
+    void new_buffer(size_t new_capacity);
+    void release();
+
+private:
+    size_t size_;
+    // INLINE_LIMBS while limbs are kept inline
+    size_t capacity_;
+    union buffer
+    {
+        uint32_t limbs[INLINE_LIMBS];
+        shared_buffer* heap;
+    } buffer_;
+};
+
+inline uint32_t* limb_storage::shared_buffer::limbs()
+{
+    return reinterpret_cast<uint32_t*>(this + 1);
+}
+
+inline limb_storage::limb_storage()
+    : size_(0)
+    , capacity_(INLINE_LIMBS)
+    , buffer_()
+{}
+
+// short numbers are copied inline even if other keeps them in a heap buffer
+inline limb_storage::limb_storage(limb_storage const& other)
+    : size_(other.size_)
+    , capacity_(INLINE_LIMBS)
+    , buffer_()
+{
+    if (other.size_ <= INLINE_LIMBS)
+    {
+        std::copy(other.data(), other.data() + other.size_, buffer_.limbs);
+        return;
+    }
+    buffer_.heap = other.buffer_.heap;
+    capacity_ = other.capacity_;
+    // the new reference is made from an existing one, nothing is published
+    buffer_.heap->refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+// short numbers are copied into the inline limbs directly
+inline limb_storage& limb_storage::operator=(limb_storage const& other)
+{
+    if (is_inline() && other.size_ <= INLINE_LIMBS)
+    {
+        std::copy(other.data(), other.data() + other.size_, buffer_.limbs);
+        size_ = other.size_;
+        return *this;
+    }
+    limb_storage tmp(other);
+    swap(tmp);
+    return *this;
+}
+
+inline limb_storage::limb_storage(limb_storage&& other) noexcept
+    : size_(0)
+    , capacity_(INLINE_LIMBS)
+    , buffer_()
+{
+    swap(other);
+}
+
+inline limb_storage& limb_storage::operator=(limb_storage&& other) noexcept
+{
+    swap(other);
+    return *this;
+}
+
+inline limb_storage::~limb_storage()
+{
+    release();
+}
+
+inline uint32_t& limb_storage::operator[](size_t i)
+{
+    return data()[i];
+}
+
+inline uint32_t const& limb_storage::operator[](size_t i) const
+{
+    return data()[i];
+}
+
+inline size_t limb_storage::size() const
+{
+    return size_;
+}
+
+inline uint32_t& limb_storage::back()
+{
+    return data()[size_ - 1];
+}
+
+inline uint32_t const& limb_storage::back() const
+{
+    return data()[size_ - 1];
+}
+
+inline void limb_storage::push_back(uint32_t a)
+{
+    if (size_ == capacity_)
+        new_buffer(std::max(2 * capacity_, INLINE_LIMBS + 1));
+    data()[size_++] = a;
+}
+
+// limbs past the size may be used by other copies, so only the size changes
+inline void limb_storage::pop_back()
+{
+    --size_;
+}
+
+inline void limb_storage::resize(size_t new_size)
+{
+    if (new_size > capacity_)
+        new_buffer(std::max(new_size, 2 * capacity_));
+    if (new_size > size_)
+    {
+        uint32_t* p = data();
+        std::fill(p + size_, p + new_size, 0);
+    }
+    size_ = new_size;
+}
+
+inline void limb_storage::swap(limb_storage& other) noexcept
+{
+    std::swap(size_, other.size_);
+    std::swap(capacity_, other.capacity_);
+    std::swap(buffer_, other.buffer_);
+}
+
+inline bool limb_storage::is_inline() const
+{
+    return capacity_ == INLINE_LIMBS;
+}
+
+// limbs for writing, a shared buffer is cloned first
+inline uint32_t* limb_storage::data()
+{
+    if (is_inline())
+        return buffer_.limbs;
+    // acquire pairs with the release of the other copies, their reads of
+    // the limbs happen before the limbs are changed here
+    if (buffer_.heap->refs.load(std::memory_order_acquire) != 1)
+        unshare();
+    return buffer_.heap->limbs();
+}
+
+inline uint32_t const* limb_storage::data() const
+{
+    return is_inline() ? buffer_.limbs : buffer_.heap->limbs();
+}
+
+inline void limb_storage::unshare()
+{
+    new_buffer(capacity_);
+}
+
+inline void limb_storage::release()
+{
+    if (!is_inline() && buffer_.heap->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        operator delete(buffer_.heap);
+}
+
+#endif // LIMB_STORAGE_H
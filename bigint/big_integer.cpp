@@ -1,100 +1,489 @@
 #include "big_integer.h"
 
-#include <cstring>
+#include <algorithm>
+#include <ostream>
 #include <stdexcept>
+#include <utility>
 
-big_integer::big_integer()
+namespace
+{
+typedef big_integer::limb_t limb_t;
+typedef big_integer::storage_t storage_t;
+
+size_t const LIMB_BITS = 32;
+uint64_t const LIMB_BASE = uint64_t(1) << LIMB_BITS;
+
+// largest power of 10 that fits into a limb, strings are converted by
+// chunks of DECIMAL_DIGITS digits
+limb_t const DECIMAL_BASE = 1000000000;
+size_t const DECIMAL_DIGITS = 9;
+
+void trim(storage_t& a)
+{
+    while (a.size() != 0 && a.back() == 0)
+        a.pop_back();
+}
+
+// -1, 0 or 1 as a is less than, equal to or greater than b
+int compare_magnitudes(storage_t const& a, storage_t const& b)
+{
+    if (a.size() != b.size())
+        return a.size() < b.size() ? -1 : 1;
+    for (size_t i = a.size(); i != 0; --i)
+        if (a[i - 1] != b[i - 1])
+            return a[i - 1] < b[i - 1] ? -1 : 1;
+    return 0;
+}
+
+// a += b
+void add_magnitudes(storage_t& a, storage_t const& b)
+{
+    size_t n = std::max(a.size(), b.size());
+    size_t m = b.size();
+    a.resize(n);
+    uint64_t carry = 0;
+    for (size_t i = 0; i != n; ++i)
+    {
+        uint64_t sum = carry + a[i] + (i < m ? b[i] : 0);
+        a[i] = static_cast<limb_t>(sum);
+        carry = sum >> LIMB_BITS;
+    }
+    if (carry != 0)
+        a.push_back(static_cast<limb_t>(carry));
+}
+
+// a += b
+void add_short(storage_t& a, limb_t b)
+{
+    uint64_t carry = b;
+    for (size_t i = 0; i != a.size() && carry != 0; ++i)
+    {
+        uint64_t sum = carry + a[i];
+        a[i] = static_cast<limb_t>(sum);
+        carry = sum >> LIMB_BITS;
+    }
+    if (carry != 0)
+        a.push_back(static_cast<limb_t>(carry));
+}
+
+// r = a - b, a >= b; r may be a or b
+void sub_magnitudes(storage_t& r, storage_t const& a, storage_t const& b)
+{
+    size_t n = a.size();
+    size_t m = b.size();
+    r.resize(n);
+    uint64_t borrow = 0;
+    for (size_t i = 0; i != n; ++i)
+    {
+        uint64_t diff = uint64_t(a[i]) - (i < m ? b[i] : 0) - borrow;
+        r[i] = static_cast<limb_t>(diff);
+        borrow = diff >> (2 * LIMB_BITS - 1);
+    }
+    trim(r);
+}
+
+// a *= b
+void mul_short(storage_t& a, limb_t b)
+{
+    uint64_t carry = 0;
+    for (size_t i = 0; i != a.size(); ++i)
+    {
+        uint64_t product = uint64_t(a[i]) * b + carry;
+        a[i] = static_cast<limb_t>(product);
+        carry = product >> LIMB_BITS;
+    }
+    if (carry != 0)
+        a.push_back(static_cast<limb_t>(carry));
+    trim(a);
+}
+
+// a /= b, returns remainder, b != 0
+limb_t div_short(storage_t& a, limb_t b)
+{
+    uint64_t rem = 0;
+    for (size_t i = a.size(); i != 0; --i)
+    {
+        uint64_t cur = (rem << LIMB_BITS) | a[i - 1];
+        a[i - 1] = static_cast<limb_t>(cur / b);
+        rem = cur % b;
+    }
+    trim(a);
+    return static_cast<limb_t>(rem);
+}
+
+// product by rows, every row adds a times a limb of b
+storage_t mul_magnitudes(storage_t const& a, storage_t const& b)
+{
+    storage_t r;
+    if (a.size() == 0 || b.size() == 0)
+        return r;
+    r.resize(a.size() + b.size());
+    for (size_t i = 0; i != b.size(); ++i)
+    {
+        uint64_t carry = 0;
+        for (size_t j = 0; j != a.size(); ++j)
+        {
+            uint64_t cur = uint64_t(a[j]) * b[i] + r[i + j] + carry;
+            r[i + j] = static_cast<limb_t>(cur);
+            carry = cur >> LIMB_BITS;
+        }
+        r[i + a.size()] = static_cast<limb_t>(carry);
+    }
+    trim(r);
+    return r;
+}
+
+// a <<= shift, 0 <= shift < LIMB_BITS, a grows by one limb if needed
+void shift_limbs_left(storage_t& a, size_t shift)
+{
+    if (shift == 0 || a.size() == 0)
+        return;
+    limb_t top = a.back() >> (LIMB_BITS - shift);
+    for (size_t i = a.size() - 1; i != 0; --i)
+        a[i] = (a[i] << shift) | (a[i - 1] >> (LIMB_BITS - shift));
+    a[0] <<= shift;
+    if (top != 0)
+        a.push_back(top);
+}
+
+// a >>= shift, 0 <= shift < LIMB_BITS
+void shift_limbs_right(storage_t& a, size_t shift)
+{
+    if (shift == 0 || a.size() == 0)
+        return;
+    for (size_t i = 0; i + 1 != a.size(); ++i)
+        a[i] = (a[i] >> shift) | (a[i + 1] << (LIMB_BITS - shift));
+    a.back() >>= shift;
+    trim(a);
+}
+
+// q = a / b, a becomes the remainder; b has at least two limbs and a >= b;
+// Knuth's algorithm D: b is shifted until its top bit is set, then every
+// limb of the quotient is estimated from the top limbs and corrected
+storage_t div_magnitudes(storage_t& a, storage_t b)
+{
+    size_t shift = 0;
+    while ((b.back() << shift) >> (LIMB_BITS - 1) == 0)
+        ++shift;
+    shift_limbs_left(b, shift);
+    a.push_back(0);
+    shift_limbs_left(a, shift);
+
+    size_t n = b.size();
+    size_t m = a.size() - n;
+    storage_t q;
+    q.resize(m);
+    for (size_t j = m; j-- != 0;)
+    {
+        uint64_t top = (uint64_t(a[j + n]) << LIMB_BITS) | a[j + n - 1];
+        uint64_t qhat = top / b[n - 1];
+        uint64_t rhat = top % b[n - 1];
+        while (qhat >= LIMB_BASE || qhat * b[n - 2] > ((rhat << LIMB_BITS) | a[j + n - 2]))
+        {
+            --qhat;
+            rhat += b[n - 1];
+            if (rhat >= LIMB_BASE)
+                break;
+        }
+
+        uint64_t carry = 0;
+        uint64_t borrow = 0;
+        for (size_t i = 0; i != n; ++i)
+        {
+            uint64_t product = qhat * b[i] + carry;
+            carry = product >> LIMB_BITS;
+            uint64_t diff = uint64_t(a[i + j]) - static_cast<limb_t>(product) - borrow;
+            a[i + j] = static_cast<limb_t>(diff);
+            borrow = diff >> (2 * LIMB_BITS - 1);
+        }
+        uint64_t diff = uint64_t(a[j + n]) - carry - borrow;
+        a[j + n] = static_cast<limb_t>(diff);
+
+        // qhat was one too big, b is added back
+        if (diff >> (2 * LIMB_BITS - 1))
+        {
+            --qhat;
+            carry = 0;
+            for (size_t i = 0; i != n; ++i)
+            {
+                uint64_t sum = uint64_t(a[i + j]) + b[i] + carry;
+                a[i + j] = static_cast<limb_t>(sum);
+                carry = sum >> LIMB_BITS;
+            }
+            a[j + n] += static_cast<limb_t>(carry);
+        }
+        q[j] = static_cast<limb_t>(qhat);
+    }
+    trim(q);
+    trim(a);
+    shift_limbs_right(a, shift);
+    return q;
+}
+
+// q = a / b, a becomes the remainder
+storage_t divide(storage_t& a, storage_t const& b)
+{
+    if (b.size() == 0)
+        throw std::runtime_error("division by zero");
+    storage_t q;
+    if (compare_magnitudes(a, b) < 0)
+        return q;
+    if (b.size() == 1)
+    {
+        q = a;
+        limb_t rem = div_short(q, b[0]);
+        a.resize(0);
+        if (rem != 0)
+            a.push_back(rem);
+        return q;
+    }
+    return div_magnitudes(a, b);
+}
+
+// two's complement of a number of n limbs, n is greater than the length of
+// magnitude, so the top limb holds the sign
+void to_twos_complement(storage_t& a, bool negative, size_t n)
+{
+    a.resize(n);
+    if (!negative)
+        return;
+    uint64_t carry = 1;
+    for (size_t i = 0; i != n; ++i)
+    {
+        uint64_t sum = uint64_t(static_cast<limb_t>(~a[i])) + carry;
+        a[i] = static_cast<limb_t>(sum);
+        carry = sum >> LIMB_BITS;
+    }
+}
+
+// inverse of to_twos_complement, returns sign
+bool from_twos_complement(storage_t& a)
+{
+    bool negative = a.back() >> (LIMB_BITS - 1);
+    to_twos_complement(a, negative, a.size());
+    trim(a);
+    return negative;
+}
+
+limb_t and_limbs(limb_t a, limb_t b)
 {
-    mpz_init(mpz);
+    return a & b;
 }
 
+limb_t or_limbs(limb_t a, limb_t b)
+{
+    return a | b;
+}
+
+limb_t xor_limbs(limb_t a, limb_t b)
+{
+    return a ^ b;
+}
+}
+
+big_integer::big_integer()
+    : negative(false)
+{}
+
 big_integer::big_integer(big_integer const& other)
+    : negative(other.negative)
+    , limbs(other.limbs)
+{}
+
+big_integer::big_integer(big_integer&& other) noexcept
+    : negative(false)
 {
-    mpz_init_set(mpz, other.mpz);
+    swap(other);
 }
 
 big_integer::big_integer(int a)
+    : negative(a < 0)
 {
-    mpz_init_set_si(mpz, a);
+    // magnitude of INT_MIN does not fit into int
+    uint64_t magnitude = a < 0 ? -int64_t(a) : a;
+    while (magnitude != 0)
+    {
+        limbs.push_back(static_cast<limb_t>(magnitude));
+        magnitude >>= LIMB_BITS;
+    }
 }
 
 big_integer::big_integer(std::string const& str)
+    : negative(false)
 {
-    if (mpz_init_set_str(mpz, str.c_str(), 10))
-    {
-        mpz_clear(mpz);
+    size_t start = str.size() != 0 && str[0] == '-' ? 1 : 0;
+    if (start == str.size())
         throw std::runtime_error("invalid string");
+    for (size_t i = start; i != str.size(); ++i)
+        if (str[i] < '0' || str[i] > '9')
+            throw std::runtime_error("invalid string");
+
+    // the first chunk is shorter, so that the rest have DECIMAL_DIGITS digits
+    size_t end = start + (str.size() - start) % DECIMAL_DIGITS;
+    if (end == start)
+        end += DECIMAL_DIGITS;
+    for (; start != str.size(); start = end, end += DECIMAL_DIGITS)
+    {
+        limb_t chunk = 0;
+        limb_t scale = 1;
+        for (size_t i = start; i != end; ++i)
+        {
+            chunk = chunk * 10 + (str[i] - '0');
+            scale *= 10;
+        }
+        mul_short(limbs, scale);
+        add_short(limbs, chunk);
     }
+    negative = str[0] == '-';
+    normalize();
 }
 
 big_integer::~big_integer()
+{}
+
+big_integer& big_integer::operator=(big_integer const& other)
 {
-    mpz_clear(mpz);
+    negative = other.negative;
+    limbs = other.limbs;
+    return *this;
 }
 
-big_integer& big_integer::operator=(big_integer const& other)
+big_integer& big_integer::operator=(big_integer&& other) noexcept
 {
-    mpz_set(mpz, other.mpz);
+    swap(other);
     return *this;
 }
 
+void big_integer::swap(big_integer& other) noexcept
+{
+    std::swap(negative, other.negative);
+    limbs.swap(other.limbs);
+}
+
 big_integer& big_integer::operator+=(big_integer const& rhs)
 {
-    mpz_add(mpz, mpz, rhs.mpz);
+    if (negative == rhs.negative)
+    {
+        add_magnitudes(limbs, rhs.limbs);
+    }
+    else if (compare_magnitudes(limbs, rhs.limbs) >= 0)
+    {
+        sub_magnitudes(limbs, limbs, rhs.limbs);
+    }
+    else
+    {
+        sub_magnitudes(limbs, rhs.limbs, limbs);
+        negative = rhs.negative;
+    }
+    normalize();
     return *this;
 }
 
 big_integer& big_integer::operator-=(big_integer const& rhs)
 {
-    mpz_sub(mpz, mpz, rhs.mpz);
+    if (this == &rhs)
+        return *this = 0;
+    negative = !negative;
+    *this += rhs;
+    negative = !negative;
+    normalize();
     return *this;
 }
 
 big_integer& big_integer::operator*=(big_integer const& rhs)
 {
-    mpz_mul(mpz, mpz, rhs.mpz);
+    if (rhs.limbs.size() == 1)
+        mul_short(limbs, rhs.limbs[0]);
+    else
+        limbs = mul_magnitudes(limbs, rhs.limbs);
+    negative = negative != rhs.negative;
+    normalize();
     return *this;
 }
 
 big_integer& big_integer::operator/=(big_integer const& rhs)
 {
-    mpz_tdiv_q(mpz, mpz, rhs.mpz);
+    storage_t rem = limbs;
+    limbs = divide(rem, rhs.limbs);
+    negative = negative != rhs.negative;
+    normalize();
     return *this;
 }
 
 big_integer& big_integer::operator%=(big_integer const& rhs)
 {
-    mpz_tdiv_r(mpz, mpz, rhs.mpz);
+    divide(limbs, rhs.limbs);
+    normalize();
     return *this;
 }
 
-big_integer& big_integer::operator&=(big_integer const& rhs)
+big_integer& big_integer::bitwise(big_integer const& rhs, limb_t (*op)(limb_t, limb_t))
 {
-    mpz_and(mpz, mpz, rhs.mpz);
+    size_t n = std::max(limbs.size(), rhs.limbs.size()) + 1;
+    storage_t other = rhs.limbs;
+    to_twos_complement(limbs, negative, n);
+    to_twos_complement(other, rhs.negative, n);
+    for (size_t i = 0; i != n; ++i)
+        limbs[i] = op(limbs[i], other[i]);
+    negative = from_twos_complement(limbs);
     return *this;
 }
 
+big_integer& big_integer::operator&=(big_integer const& rhs)
+{
+    return bitwise(rhs, and_limbs);
+}
+
 big_integer& big_integer::operator|=(big_integer const& rhs)
 {
-    mpz_ior(mpz, mpz, rhs.mpz);
-    return *this;
+    return bitwise(rhs, or_limbs);
 }
 
 big_integer& big_integer::operator^=(big_integer const& rhs)
 {
-    mpz_xor(mpz, mpz, rhs.mpz);
-    return *this;
+    return bitwise(rhs, xor_limbs);
 }
 
 big_integer& big_integer::operator<<=(int rhs)
 {
-    mpz_mul_2exp(mpz, mpz, rhs);
+    if (limbs.size() == 0)
+        return *this;
+    size_t whole = rhs / LIMB_BITS;
+    limbs.resize(limbs.size() + whole);
+    for (size_t i = limbs.size(); i-- > whole;)
+        limbs[i] = limbs[i - whole];
+    for (size_t i = 0; i != whole; ++i)
+        limbs[i] = 0;
+    shift_limbs_left(limbs, rhs % LIMB_BITS);
     return *this;
 }
 
+// rounds towards minus infinity, so a negative number whose shifted out bits
+// are not all zero gets one added to the magnitude
 big_integer& big_integer::operator>>=(int rhs)
 {
-    mpz_div_2exp(mpz, mpz, rhs);
+    size_t whole = rhs / LIMB_BITS;
+    if (whole >= limbs.size())
+    {
+        limbs.resize(0);
+        if (negative)
+            limbs.push_back(1);
+        return *this;
+    }
+
+    bool inexact = false;
+    for (size_t i = 0; i != whole; ++i)
+        inexact = inexact || limbs[i] != 0;
+    size_t shift = rhs % LIMB_BITS;
+    inexact = inexact || static_cast<limb_t>(limbs[whole] << (LIMB_BITS - 1 - shift) << 1) != 0;
+
+    for (size_t i = whole; i != limbs.size(); ++i)
+        limbs[i - whole] = limbs[i];
+    limbs.resize(limbs.size() - whole);
+    shift_limbs_right(limbs, shift);
+    if (negative && inexact)
+        add_short(limbs, 1);
+    normalize();
     return *this;
 }
 
@@ -105,22 +494,20 @@ big_integer big_integer::operator+() const
 
 big_integer big_integer::operator-() const
 {
-    big_integer r;
-    mpz_neg(r.mpz, mpz);
+    big_integer r = *this;
+    r.negative = !negative;
+    r.normalize();
     return r;
 }
 
 big_integer big_integer::operator~() const
 {
-    big_integer r;
-    mpz_com(r.mpz, mpz);
-    return r;
+    return -*this - 1;
 }
 
 big_integer& big_integer::operator++()
 {
-    mpz_add_ui(mpz, mpz, 1);
-    return *this;
+    return *this += 1;
 }
 
 big_integer big_integer::operator++(int)
@@ -132,8 +519,7 @@ big_integer big_integer::operator++(int)
 
 big_integer& big_integer::operator--()
 {
-    mpz_sub_ui(mpz, mpz, 1);
-    return *this;
+    return *this -= 1;
 }
 
 big_integer big_integer::operator--(int)
@@ -143,96 +529,163 @@ big_integer big_integer::operator--(int)
     return r;
 }
 
+// zero has no limbs and is never negative
+void big_integer::normalize()
+{
+    trim(limbs);
+    if (limbs.size() == 0)
+        negative = false;
+}
+
 big_integer operator+(big_integer a, big_integer const& b)
 {
-    return a += b;
+    a += b;
+    return a;
+}
+
+big_integer operator+(big_integer const& a, big_integer&& b)
+{
+    b += a;
+    return std::move(b);
 }
 
 big_integer operator-(big_integer a, big_integer const& b)
 {
-    return a -= b;
+    a -= b;
+    return a;
 }
 
 big_integer operator*(big_integer a, big_integer const& b)
 {
-    return a *= b;
+    a *= b;
+    return a;
+}
+
+big_integer operator*(big_integer const& a, big_integer&& b)
+{
+    b *= a;
+    return std::move(b);
 }
 
 big_integer operator/(big_integer a, big_integer const& b)
 {
-    return a /= b;
+    a /= b;
+    return a;
 }
 
 big_integer operator%(big_integer a, big_integer const& b)
 {
-    return a %= b;
+    a %= b;
+    return a;
 }
 
 big_integer operator&(big_integer a, big_integer const& b)
 {
-    return a &= b;
+    a &= b;
+    return a;
+}
+
+big_integer operator&(big_integer const& a, big_integer&& b)
+{
+    b &= a;
+    return std::move(b);
 }
 
 big_integer operator|(big_integer a, big_integer const& b)
 {
-    return a |= b;
+    a |= b;
+    return a;
+}
+
+big_integer operator|(big_integer const& a, big_integer&& b)
+{
+    b |= a;
+    return std::move(b);
 }
 
 big_integer operator^(big_integer a, big_integer const& b)
 {
-    return a ^= b;
+    a ^= b;
+    return a;
+}
+
+big_integer operator^(big_integer const& a, big_integer&& b)
+{
+    b ^= a;
+    return std::move(b);
 }
 
 big_integer operator<<(big_integer a, int b)
 {
-    return a <<= b;
+    a <<= b;
+    return a;
 }
 
 big_integer operator>>(big_integer a, int b)
 {
-    return a >>= b;
+    a >>= b;
+    return a;
 }
 
 bool operator==(big_integer const& a, big_integer const& b)
 {
-    return mpz_cmp(a.mpz, b.mpz) == 0;
+    return a.negative == b.negative && compare_magnitudes(a.limbs, b.limbs) == 0;
 }
 
 bool operator!=(big_integer const& a, big_integer const& b)
 {
-    return mpz_cmp(a.mpz, b.mpz) != 0;
+    return !(a == b);
 }
 
 bool operator<(big_integer const& a, big_integer const& b)
 {
-    return mpz_cmp(a.mpz, b.mpz) < 0;
+    if (a.negative != b.negative)
+        return a.negative;
+    int cmp = compare_magnitudes(a.limbs, b.limbs);
+    return a.negative ? cmp > 0 : cmp < 0;
 }
 
 bool operator>(big_integer const& a, big_integer const& b)
 {
-    return mpz_cmp(a.mpz, b.mpz) > 0;
+    return b < a;
 }
 
 bool operator<=(big_integer const& a, big_integer const& b)
 {
-    return mpz_cmp(a.mpz, b.mpz) <= 0;
+    return !(b < a);
 }
 
 bool operator>=(big_integer const& a, big_integer const& b)
 {
-    return mpz_cmp(a.mpz, b.mpz) >= 0;
+    return !(a < b);
 }
 
-std::string to_string(big_integer const& a)
+void swap(big_integer& a, big_integer& b) noexcept
 {
-    char* tmp = mpz_get_str(NULL, 10, a.mpz);
-    std::string res = tmp;
-
-    void (*freefunc)(void*, size_t);
-    mp_get_memory_functions (NULL, NULL, &freefunc);
+    a.swap(b);
+}
 
-    freefunc(tmp, strlen(tmp) + 1);
+std::string to_string(big_integer const& a)
+{
+    if (a.limbs.size() == 0)
+        return "0";
 
+    // chunks of DECIMAL_DIGITS digits from the lowest one, digits are
+    // collected in reverse order
+    std::string res;
+    big_integer::storage_t rest = a.limbs;
+    while (rest.size() != 0)
+    {
+        limb_t chunk = div_short(rest, DECIMAL_BASE);
+        for (size_t i = 0; i != DECIMAL_DIGITS && (rest.size() != 0 || chunk != 0); ++i)
+        {
+            res.push_back(static_cast<char>('0' + chunk % 10));
+            chunk /= 10;
+        }
+    }
+    if (a.negative)
+        res.push_back('-');
+    std::reverse(res.begin(), res.end());
     return res;
 }
 
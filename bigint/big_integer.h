@@ -2,18 +2,32 @@
 #define BIG_INTEGER_H
 
 #include <cstddef>
-#include <gmp.h>
+#include <cstdint>
 #include <iosfwd>
+#include <string>
+#include <vector>
 
 struct big_integer
 {
+    // magnitude is kept in limbs, least significant limb first, without
+    // leading zero limbs, so zero has no limbs; storage_t only needs size,
+    // resize, operator[], back, push_back and pop_back
+    using limb_t = uint32_t;
+    using storage_t = std::vector<limb_t>;
+
     big_integer();
     big_integer(big_integer const& other);
+    // other is left zero
+    big_integer(big_integer&& other) noexcept;
     big_integer(int a);
     explicit big_integer(std::string const& str);
     ~big_integer();
 
     big_integer& operator=(big_integer const& other);
+    // other is left with the old value of *this
+    big_integer& operator=(big_integer&& other) noexcept;
+
+    void swap(big_integer& other) noexcept;
 
     big_integer& operator+=(big_integer const& rhs);
     big_integer& operator-=(big_integer const& rhs);
@@ -48,18 +62,32 @@ struct big_integer
     friend std::string to_string(big_integer const& a);
 
 private:
-    mpz_t mpz;
+    big_integer& bitwise(big_integer const& rhs, limb_t (*op)(limb_t, limb_t));
+    void normalize();
+
+    bool negative;
+    storage_t limbs;
 };
 
+void swap(big_integer& a, big_integer& b) noexcept;
+
+// the left operand is taken by value, so a temporary one is moved in and
+// its limbs are reused for the result; commutative operators reuse a
+// temporary right operand as well
 big_integer operator+(big_integer a, big_integer const& b);
+big_integer operator+(big_integer const& a, big_integer&& b);
 big_integer operator-(big_integer a, big_integer const& b);
 big_integer operator*(big_integer a, big_integer const& b);
+big_integer operator*(big_integer const& a, big_integer&& b);
 big_integer operator/(big_integer a, big_integer const& b);
 big_integer operator%(big_integer a, big_integer const& b);
 
 big_integer operator&(big_integer a, big_integer const& b);
+big_integer operator&(big_integer const& a, big_integer&& b);
 big_integer operator|(big_integer a, big_integer const& b);
+big_integer operator|(big_integer const& a, big_integer&& b);
 big_integer operator^(big_integer a, big_integer const& b);
+big_integer operator^(big_integer const& a, big_integer&& b);
 
 big_integer operator<<(big_integer a, int b);
 big_integer operator>>(big_integer a, int b);
@@ -76,6 +76,38 @@ TEST(correctness, assignment_return_value) {
   EXPECT_TRUE(b == 7);
 }
 
+TEST(correctness, move_ctor) {
+  big_integer a("-123456789012345678901234567890");
+  big_integer b = std::move(a);
+
+  EXPECT_EQ(big_integer("-123456789012345678901234567890"), b);
+  EXPECT_EQ(0, a);
+}
+
+TEST(correctness, move_assignment) {
+  big_integer a("123456789012345678901234567890");
+  big_integer b = 7;
+  b = std::move(a);
+
+  EXPECT_EQ(big_integer("123456789012345678901234567890"), b);
+  a = 5;
+  EXPECT_EQ(5, a);
+}
+
+TEST(correctness, rvalue_operands) {
+  big_integer a("123456789012345678901234567890");
+  big_integer b("-98765432109876543210");
+
+  EXPECT_EQ(a * b + a, big_integer(a) * b + a);
+  EXPECT_EQ(a + a * b, a + big_integer(a) * b);
+  EXPECT_EQ(a * 2, a + big_integer(a));
+  EXPECT_EQ(a * a, a * big_integer(a));
+  EXPECT_EQ(b & a, big_integer(b) & a);
+  EXPECT_EQ(b | a, a | big_integer(b));
+  EXPECT_EQ(0, (a ^ big_integer(a)));
+  EXPECT_EQ(a - b, (a - 0) - (b - 0));
+}
+
 TEST(correctness, comparisons) {
   big_integer a = 100;
   big_integer b = 100;